@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "post_run_py.h"
+
+/* bench.c
+
+   Times the phases of one post_run_py run over the files gen_network made in
+   a directory, and appends a JSON object per phase to the results file, one
+   per line, so that runs can be compared over time:
+
+     {"label":..., "phase":..., "wall_s":..., "items":..., "items_per_s":...,
+      "bytes":..., "mb_per_s":..., "syscalls":..., "peak_rss_kb":..., ...}
+
+   The phases are 'load' (parsing the .cyjs file and building its lookup
+   tables and snapshot), 'reload' (opening it again from the snapshot),
+   'in_txt', 'paths' (or 'ksp' when the paths are found rather than read),
+   'flag', 'write' (the subset network) and 'report'. The peak RSS is that of
+   the phase alone where the kernel can reset it (Linux), and the peak of the
+   process so far elsewhere. The system calls are those writing the report,
+   only counted for 'report'.
+
+   Usage: bench [-t <threads>] [-k <paths to find>] [-c] [-l <label>]
+                [-o <results file>] <dir>
+*/
+
+struct phase {
+	const char * name;
+	struct timespec start;
+	long   syscalls;
+};
+
+struct bench {
+	FILE * results;
+	const char * label;
+	struct network * net;
+	int    num_threads;
+	int    ksp_paths;
+};
+
+static void reset_peak_rss( void ) {
+	FILE * f;
+
+	f = fopen( "/proc/self/clear_refs", "w" );
+
+	if (f != NULL) {
+		fputs( "5", f );
+		fclose( f );
+	}
+}
+
+static long peak_rss_kb( void ) {
+	struct rusage usage;
+	char   line[256];
+	long   kb;
+	FILE * f;
+
+	f = fopen( "/proc/self/status", "r" );
+
+	if (f != NULL) {
+		while (fgets( line, sizeof( line ), f ) != NULL) {
+			if (sscanf( line, "VmHWM: %ld", &kb ) == 1) {
+				fclose( f );
+				return kb;
+			}
+		}
+
+		fclose( f );
+	}
+
+	getrusage( RUSAGE_SELF, &usage );
+#if defined(__APPLE__)
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+static long file_size( const char * file_name ) {
+	struct stat st;
+
+	return (stat( file_name, &st ) == 0) ? (long) st.st_size : 0;
+}
+
+static void start_phase( struct phase * phase, const char * name ) {
+	reset_peak_rss();
+	phase->name = name;
+	phase->syscalls = 0;
+	clock_gettime( CLOCK_MONOTONIC, &phase->start );
+}
+
+/* Record a phase that handled 'items' things (records, paths, hops) and
+   'bytes' bytes of file.
+*/
+static void end_phase( struct bench * bench, struct phase * phase, long items, long bytes ) {
+	struct timespec end;
+	double wall;
+
+	clock_gettime( CLOCK_MONOTONIC, &end );
+	wall = (end.tv_sec - phase->start.tv_sec) + (end.tv_nsec - phase->start.tv_nsec) / 1e9;
+
+	if (wall <= 0.0)
+		wall = 1e-9;
+
+	fprintf( bench->results,
+	         "{\"label\":\"%s\",\"phase\":\"%s\",\"wall_s\":%.6f,\"items\":%ld,\"items_per_s\":%.1f,"
+	         "\"bytes\":%ld,\"mb_per_s\":%.3f,\"syscalls\":%ld,\"peak_rss_kb\":%ld,\"nodes\":%d,\"edges\":%d,"
+	         "\"threads\":%d,\"ksp_paths\":%d}\n",
+	         bench->label, phase->name, wall, items, items / wall, bytes, bytes / wall / 1e6, phase->syscalls,
+	         peak_rss_kb(), bench->net->num_nodes, bench->net->num_edges, bench->num_threads, bench->ksp_paths );
+	fflush( bench->results );
+
+	fprintf( stderr, "bench: %-8s %10.3f s  %12ld items  %8.1f MB/s\n", phase->name, wall, items, bytes / wall / 1e6 );
+}
+
+static void print_usage( void ) {
+	printf( "Usage: bench [-t <threads>] [-k <paths to find>] [-c] [-l <label>] [-o <results file>] <dir>\n\n" );
+	printf( "where <dir> holds the 'net.cyjs', 'in.txt' and 'paths.txt' made by gen_network.\n" );
+}
+
+int main( int argc, char ** argv ) {
+	struct bench bench;
+	struct network net;
+	struct report report;
+	struct run_files files;
+	struct run_options options;
+	struct run run;
+	struct phase phase;
+	char   names[6][4096];
+	const char * results_name;
+	const char * dir;
+	int    compact;
+	int    opt;
+	int    ret;
+
+	memset( &bench, 0, sizeof( bench ) );
+	bench.num_threads = 1;
+	results_name = "results.jsonl";
+	compact = FALSE;
+
+	while ((opt = getopt( argc, argv, "t:k:cl:o:" )) != -1) {
+		switch (opt) {
+		case 't': bench.num_threads = atoi( optarg ); break;
+		case 'k': bench.ksp_paths = atoi( optarg ); break;
+		case 'c': compact = TRUE; break;
+		case 'l': bench.label = optarg; break;
+		case 'o': results_name = optarg; break;
+		default: print_usage(); return 1;
+		}
+	}
+
+	if (optind != argc - 1 || bench.num_threads < 1 || bench.ksp_paths < 0) {
+		print_usage();
+		return 1;
+	}
+
+	dir = argv[optind];
+
+	if (bench.label == NULL)
+		bench.label = dir;
+
+	snprintf( names[0], sizeof( names[0] ), "%s/net.cyjs", dir );
+	snprintf( names[1], sizeof( names[1] ), "%s/paths.txt", dir );
+	snprintf( names[2], sizeof( names[2] ), "%s/in.txt", dir );
+	snprintf( names[3], sizeof( names[3] ), "%s/out.cyjs", dir );
+	snprintf( names[4], sizeof( names[4] ), "%s/out.txt", dir );
+	snprintf( names[5], sizeof( names[5] ), "%s/net.cyjs.snap", dir );
+
+	bench.results = fopen( results_name, "a" );
+
+	if (bench.results == NULL) {
+		printf( "unable to open '%s'\n", results_name );
+		return 1;
+	}
+
+	/* the library's progress messages go to stdout, out of the way */
+	bench.net = &net;
+	default_run_files( &files, names[1] );
+	files.in_txt = names[2];
+	files.out_cyjs = names[3];
+	files.out_txt = names[4];
+	default_run_options( &options );
+	options.num_threads = bench.num_threads;
+	options.compact_json = compact;
+	options.ksp_paths = bench.ksp_paths;
+
+	/* from the .cyjs file, not a snapshot of it, and to a new report */
+	unlink( names[5] );
+	unlink( names[4] );
+
+	begin_report( &report );
+	start_phase( &phase, "load" );
+
+	if (open_network( names[0], &net, bench.num_threads, &report ) != 0) {
+		printf( "bench: %s\n", last_out_message( &report ) );
+		return 1;
+	}
+
+	end_phase( &bench, &phase, (long) net.num_nodes + net.num_edges, file_size( names[0] ) );
+	free_network( &net );
+
+	start_phase( &phase, "reload" );
+
+	if (open_network( names[0], &net, bench.num_threads, &report ) != 0) {
+		printf( "bench: %s\n", last_out_message( &report ) );
+		return 1;
+	}
+
+	end_phase( &bench, &phase, (long) net.num_nodes + net.num_edges, file_size( names[5] ) );
+	end_report( &report, 0, NULL );
+
+	/* the same steps as process_paths(), one at a time */
+	init_run( &run );
+	ret = prepare_run( &run, &net, &files );
+
+	if (ret == 0) {
+		start_phase( &phase, "in_txt" );
+		ret = process_in_nodes( &run, files.in_txt );
+		end_phase( &bench, &phase, run.num_source + run.num_target, file_size( files.in_txt ) );
+	}
+
+	if (ret == 0) {
+		if (options.ksp_paths > 0) {
+			start_phase( &phase, "ksp" );
+			ret = find_shortest_paths( &run, options.ksp_paths );
+			end_phase( &bench, &phase, run.paths.num_paths, 0 );
+		}
+		else {
+			start_phase( &phase, "paths" );
+			ret = load_out_paths( &run, files.paths );
+			end_phase( &bench, &phase, run.paths.num_paths, file_size( files.paths ) );
+		}
+	}
+
+	if (ret == 0) {
+		start_phase( &phase, "flag" );
+		ret = flag_nodes_and_edges( &run, 0, options.num_threads );
+		end_phase( &bench, &phase, run.paths.num_hops, 0 );
+	}
+
+	if (ret == 0) {
+		start_phase( &phase, "write" );
+		ret = write_subset_network( &run, options.compact_json );
+		end_phase( &bench, &phase, run.paths.num_paths, file_size( files.out_cyjs ) );
+	}
+
+	if (ret == 0) {
+		start_phase( &phase, "report" );
+		write_paths( &run, 0 );
+		ret = flush_out_messages( &run.report, files.out_txt );
+		phase.syscalls = run.report.syscalls;
+		end_phase( &bench, &phase, run.paths.num_paths, run.report.bytes_written );
+	}
+
+	if (ret != 0)
+		printf( "bench: %s\n", last_out_message( &run.report ) );
+
+	end_report( &run.report, ret, NULL );
+	release_run( &run );
+	free_network( &net );
+	fclose( bench.results );
+
+	return (ret == 0) ? 0 : 1;
+}
@@ -0,0 +1,932 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "post_run_py.h"
+
+/* check.c
+
+   Checks of post_run_py results that the benchmarks take for granted, run
+   over the files 'make check' puts in a directory: the fixtures, and a
+   network made by gen_network that is big enough to be parsed and flagged
+   on several threads.
+
+     ksp       the k shortest paths of fixtures/ksp.cyjs come in the order
+               and at the costs worked out by hand, also when the search
+               is carried on from a smaller k
+     missing   names on the paths that aren't in the network are kept once,
+               and given up with the paths that brought them
+     ksp_all   on small random networks, the paths found are exactly all
+               the simple paths a brute force search finds, shortest first
+     load      parsing on several threads gives the same network as serially
+     snapshot  a network opened from its snapshot is the same as the one
+               loaded from the .cyjs file, lookups and all
+     flag      flagging on several threads flags the same nodes and edges,
+               and resolves the same edges, as flagging serially
+     extend    a run extended to more paths, found or read, writes the same
+               subset network and report as one made with them all at once
+
+   Usage: run_checks [-t <threads>] <dir>
+*/
+
+#define  MAX_SMALL_NODES          (12)
+#define  SMALL_EDGES              (30)
+#define  SMALL_NETWORKS           (20)
+#define  MAX_BRUTE_PATHS          (4096)
+
+static int failures;
+
+static void fail( const char * check, const char * format, ... ) {
+	va_list args;
+
+	printf( "check: %s FAILED: ", check );
+	va_start( args, format );
+	vprintf( format, args );
+	va_end( args );
+	putchar( '\n' );
+	failures++;
+}
+
+static void passed( const char * check ) {
+	printf( "check: %s ok\n", check );
+}
+
+static int same_view( const struct network * a, const struct str_view * va, const struct network * b,
+                      const struct str_view * vb )
+{
+	return va->len == vb->len && memcmp( a->text + va->off, b->text + vb->off, va->len ) == 0;
+}
+
+static int same_symbol( const struct network * a, int sa, const struct network * b, int sb ) {
+	return same_view( a, &a->pool.strings[sa], b, &b->pool.strings[sb] );
+}
+
+/* Whether two loaded networks hold the same records, attribute by attribute.
+   The symbols are compared by their strings, as the pools may differ.
+*/
+static int same_networks( const char * check, const struct network * a, const struct network * b ) {
+	int    i;
+
+	if (a->num_nodes != b->num_nodes || a->num_edges != b->num_edges) {
+		fail( check, "%d nodes and %d edges against %d and %d", a->num_nodes, a->num_edges, b->num_nodes, b->num_edges );
+		return FALSE;
+	}
+
+	for (i = 0; i < a->num_nodes; i++) {
+		if (a->node_id[i] != b->node_id[i] || a->node_SUID[i] != b->node_SUID[i] ||
+		    a->node_Prize[i] != b->node_Prize[i] ||
+		    memcmp( &a->node_FoldChange[i], &b->node_FoldChange[i], sizeof( double ) ) != 0 ||
+		    memcmp( &a->node_x[i], &b->node_x[i], sizeof( double ) ) != 0 ||
+		    memcmp( &a->node_y[i], &b->node_y[i], sizeof( double ) ) != 0 ||
+		    !same_view( a, &a->node_name[i], b, &b->node_name[i] ) ||
+		    !same_view( a, &a->node_shared_name[i], b, &b->node_shared_name[i] ) ||
+		    !same_symbol( a, a->node_Layer[i], b, b->node_Layer[i] ) ||
+		    bit_test( a->node_isExcludedFromPaths, i ) != bit_test( b->node_isExcludedFromPaths, i ) ||
+		    bit_test( a->node_isInPath, i ) != bit_test( b->node_isInPath, i ) ||
+		    bit_test( a->node_selected, i ) != bit_test( b->node_selected, i ))
+		{
+			fail( check, "node %d differs", i );
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < a->num_edges; i++) {
+		if (a->edge_id[i] != b->edge_id[i] || a->edge_source[i] != b->edge_source[i] ||
+		    a->edge_target[i] != b->edge_target[i] || a->edge_SUID[i] != b->edge_SUID[i] ||
+		    !same_view( a, &a->edge_name[i], b, &b->edge_name[i] ) ||
+		    !same_view( a, &a->edge_shared_name[i], b, &b->edge_shared_name[i] ) ||
+		    !same_symbol( a, a->edge_sh_interaction[i], b, b->edge_sh_interaction[i] ) ||
+		    !same_symbol( a, a->edge_interaction[i], b, b->edge_interaction[i] ) ||
+		    !same_symbol( a, a->edge_Time[i], b, b->edge_Time[i] ) ||
+		    bit_test( a->edge_isInPath, i ) != bit_test( b->edge_isInPath, i ) ||
+		    bit_test( a->edge_selected, i ) != bit_test( b->edge_selected, i ))
+		{
+			fail( check, "edge %d differs", i );
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static void end_run( struct run * run ) {
+	end_report( &run->report, 0, NULL );
+	release_run( run );
+}
+
+/* A run against 'net' with the source and target file 'in_txt', up to the
+   point where its paths are added. Returns -1 if it failed.
+*/
+static int start_run( struct run * run, struct network * net, struct run_files * files, const char * in_txt ) {
+	default_run_files( files, NULL );
+	files->in_txt = in_txt;
+	init_run( run );
+
+	if (prepare_run( run, net, files ) != 0 || process_in_nodes( run, in_txt ) != 0) {
+		end_run( run );
+		return -1;
+	}
+
+	return 0;
+}
+
+/* A path of a run as "name|name|...", in 'buf'.
+*/
+static const char * path_names( struct run * run, int path, char * buf, size_t size ) {
+	const char * name;
+	size_t len;
+	size_t used;
+	long   hop;
+
+	used = 0;
+	buf[0] = '\0';
+
+	for (hop = run->paths.path_start[path]; hop < run->paths.path_start[path + 1]; hop++) {
+		name = hop_name( run->net, &run->paths, run->paths.hop_node[hop], &len );
+
+		if (used + len + 2 > size)
+			break;
+
+		if (used > 0)
+			buf[used++] = '|';
+
+		memcpy( buf + used, name, len );
+		used += len;
+		buf[used] = '\0';
+	}
+
+	return buf;
+}
+
+/* Whether two files hold the same bytes. */
+static int same_files( const char * check, const char * a_name, const char * b_name ) {
+	struct mapped_file a;
+	struct mapped_file b;
+	int    same;
+
+	if (map_file( a_name, &a ) != 0) {
+		fail( check, "could not read '%s'", a_name );
+		return FALSE;
+	}
+
+	if (map_file( b_name, &b ) != 0) {
+		fail( check, "could not read '%s'", b_name );
+		unmap_file( &a );
+		return FALSE;
+	}
+
+	same = (a.size == b.size && memcmp( a.data, b.data, a.size ) == 0);
+
+	if (!same)
+		fail( check, "'%s' and '%s' differ", a_name, b_name );
+
+	unmap_file( &a );
+	unmap_file( &b );
+	return same;
+}
+
+/* Put 'len' bytes of 'data' in a new file, or after what is in it already. */
+static int put_file( const char * file_name, const char * mode, const char * data, size_t len ) {
+	FILE * f;
+
+	if ((f = fopen( file_name, mode )) == NULL)
+		return -1;
+
+	if (fwrite( data, 1, len, f ) != len) {
+		fclose( f );
+		return -1;
+	}
+
+	return (fclose( f ) == 0) ? 0 : -1;
+}
+
+static void check_ksp( const char * dir ) {
+	/* by cost; paths of the same cost in the order they are found */
+	static const char * expected[] = { "S|T", "S|A|T", "S|B|C|T", "S|A|C|T", "S|A|B|C|T" };
+	static const double expected_cost[] = { 1.0, 2.0, 3.0, 3.0, 4.0 };
+	const int num_expected = sizeof( expected ) / sizeof( expected[0] );
+	struct network net;
+	struct report report;
+	struct run_files files[2];
+	struct run run[2];
+	char   net_name[4096];
+	char   in_name[4096];
+	char   a[256];
+	char   b[256];
+	int    ok;
+	int    i;
+
+	snprintf( net_name, sizeof( net_name ), "%s/ksp.cyjs", dir );
+	snprintf( in_name, sizeof( in_name ), "%s/ksp_in.txt", dir );
+	begin_report( &report );
+
+	if (open_network( net_name, &net, 1, &report ) != 0) {
+		fail( "ksp", "could not open '%s'", net_name );
+		end_report( &report, 0, NULL );
+		return;
+	}
+
+	end_report( &report, 0, NULL );
+
+	/* all at once, and 2 first then the rest */
+	if (start_run( &run[0], &net, &files[0], in_name ) != 0 || start_run( &run[1], &net, &files[1], in_name ) != 0) {
+		fail( "ksp", "could not start the runs" );
+		free_network( &net );
+		return;
+	}
+
+	ok = (find_shortest_paths( &run[0], 10 ) == 0 && find_shortest_paths( &run[1], 2 ) == 0 &&
+	      find_shortest_paths( &run[1], 10 ) == 0);
+
+	if (!ok)
+		fail( "ksp", "the search failed" );
+	else if (run[0].paths.num_paths != num_expected)
+		fail( "ksp", "%d paths instead of %d", run[0].paths.num_paths, num_expected );
+	else if (run[1].paths.num_paths != num_expected)
+		fail( "ksp", "%d paths carrying on from k=2 instead of %d", run[1].paths.num_paths, num_expected );
+	else {
+		for (i = 0; i < num_expected; i++) {
+			path_names( &run[0], i, a, sizeof( a ) );
+			path_names( &run[1], i, b, sizeof( b ) );
+
+			if (strcmp( a, expected[i] ) != 0 || run[0].paths.cost[i] != expected_cost[i] ||
+			    run[0].paths.rank[i] != i + 1)
+			{
+				fail( "ksp", "path %d is %s at cost %g, expected %s at %g", i + 1, a, run[0].paths.cost[i],
+				      expected[i], expected_cost[i] );
+				ok = FALSE;
+			}
+
+			if (strcmp( a, b ) != 0 || run[0].paths.cost[i] != run[1].paths.cost[i]) {
+				fail( "ksp", "path %d is %s carrying on from k=2, %s at once", i + 1, b, a );
+				ok = FALSE;
+			}
+		}
+
+		if (ok)
+			passed( "ksp" );
+	}
+
+	end_run( &run[0] );
+	end_run( &run[1] );
+	free_network( &net );
+}
+
+static void check_missing( const char * dir ) {
+	static const char lines[] = "1 2 S|Q|T\n2 2 S|Q|T\n3 3 S|R|Q|T\n";
+	struct network net;
+	struct report report;
+	struct run_files files;
+	struct run run;
+	char   net_name[4096];
+	char   in_name[4096];
+	char   paths_name[4096];
+	char   names[256];
+	int    ok;
+
+	snprintf( net_name, sizeof( net_name ), "%s/ksp.cyjs", dir );
+	snprintf( in_name, sizeof( in_name ), "%s/ksp_in.txt", dir );
+	snprintf( paths_name, sizeof( paths_name ), "%s/missing_paths.txt", dir );
+	begin_report( &report );
+
+	if (open_network( net_name, &net, 1, &report ) != 0) {
+		fail( "missing", "could not open '%s'", net_name );
+		end_report( &report, 0, NULL );
+		return;
+	}
+
+	end_report( &report, 0, NULL );
+
+	if (put_file( paths_name, "w", lines, strlen( lines ) ) != 0 || start_run( &run, &net, &files, in_name ) != 0) {
+		fail( "missing", "could not start the run" );
+		free_network( &net );
+		return;
+	}
+
+	ok = (load_out_paths( &run, paths_name ) == 0);
+
+	if (!ok)
+		fail( "missing", "could not load '%s'", paths_name );
+	else if (run.paths.num_paths != 3 || run.paths.num_missing != 2) {
+		fail( "missing", "%d paths and %d missing names instead of 3 and 2", run.paths.num_paths,
+		      run.paths.num_missing );
+		ok = FALSE;
+	}
+	else if (strcmp( path_names( &run, 2, names, sizeof( names ) ), "S|R|Q|T" ) != 0) {
+		fail( "missing", "the last path is %s", names );
+		ok = FALSE;
+	}
+	else {
+		truncate_paths( &run.paths, 2 );
+
+		if (run.paths.num_missing != 1 || strcmp( path_names( &run, 1, names, sizeof( names ) ), "S|Q|T" ) != 0) {
+			fail( "missing", "%d missing names and %s after the last path was given up", run.paths.num_missing,
+			      names );
+			ok = FALSE;
+		}
+	}
+
+	if (ok)
+		passed( "missing" );
+
+	end_run( &run );
+	free_network( &net );
+	unlink( paths_name );
+}
+
+/* A small random network, with no two edges alike and no loops. Sources
+   and targets are apart, and one node in the middle is excluded.
+*/
+struct small_network {
+	int    num_nodes;
+	int    num_sources;
+	int    adj[MAX_SMALL_NODES][MAX_SMALL_NODES];
+	int    role[MAX_SMALL_NODES];
+	int    excluded;
+};
+
+#define  ROLE_NONE                (0)
+#define  ROLE_SOURCE              (1)
+#define  ROLE_TARGET              (2)
+
+static unsigned long long rng_state;
+
+/* xorshift64*, like gen_network */
+static unsigned long long next_random( void ) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 2685821657736338717ULL;
+}
+
+static int random_below( int n ) {
+	return (int) (next_random() % (unsigned long long) n);
+}
+
+static void make_small_network( struct small_network * small ) {
+	int    edges;
+	int    u;
+	int    v;
+	int    i;
+
+	memset( small, 0, sizeof( *small ) );
+	small->num_nodes = 8 + random_below( MAX_SMALL_NODES - 8 + 1 );
+
+	for (edges = 0; edges < SMALL_EDGES; ) {
+		u = random_below( small->num_nodes );
+		v = random_below( small->num_nodes );
+
+		if (u != v && !small->adj[u][v]) {
+			small->adj[u][v] = TRUE;
+			edges++;
+		}
+	}
+
+	/* two sources, two targets and an excluded node, all different */
+	small->role[0] = ROLE_SOURCE;
+	small->role[1] = ROLE_SOURCE;
+	small->role[2] = ROLE_TARGET;
+	small->role[3] = ROLE_TARGET;
+	small->excluded = 4;
+
+	for (i = 0; i < small->num_nodes; i++)
+		if (small->role[i] == ROLE_SOURCE)
+			small->num_sources++;
+}
+
+static int write_small_network( const struct small_network * small, const char * net_name, const char * in_name ) {
+	FILE * f;
+	int    first;
+	int    u;
+	int    v;
+
+	if ((f = fopen( net_name, "w" )) == NULL)
+		return -1;
+
+	fprintf( f, "{\n  \"elements\" : {\n    \"nodes\" : [" );
+
+	for (u = 0; u < small->num_nodes; u++)
+		fprintf( f, "%s {\n      \"data\" : { \"id\" : \"%d\", \"name\" : \"N%d\", \"isExcludedFromPaths\" : %s }\n    }",
+		         (u > 0) ? "," : "", 100 + u, u, (u == small->excluded) ? "true" : "false" );
+
+	fprintf( f, " ],\n    \"edges\" : [" );
+	first = TRUE;
+
+	for (u = 0; u < small->num_nodes; u++) {
+		for (v = 0; v < small->num_nodes; v++) {
+			if (!small->adj[u][v])
+				continue;
+
+			fprintf( f, "%s {\n      \"data\" : { \"id\" : \"%d\", \"source\" : \"%d\", \"target\" : \"%d\" }\n    }",
+			         first ? "" : ",", 1000 + u * MAX_SMALL_NODES + v, 100 + u, 100 + v );
+			first = FALSE;
+		}
+	}
+
+	fprintf( f, " ]\n  }\n}\n" );
+
+	if (fclose( f ) != 0 || (f = fopen( in_name, "w" )) == NULL)
+		return -1;
+
+	fprintf( f, "#node\tnode_symbol\n" );
+
+	for (u = 0; u < small->num_nodes; u++) {
+		if (small->role[u] == ROLE_SOURCE)
+			fprintf( f, "N%d\tsource\n", u );
+		else if (small->role[u] == ROLE_TARGET)
+			fprintf( f, "N%d\ttarget\n", u );
+	}
+
+	return (fclose( f ) == 0) ? 0 : -1;
+}
+
+struct brute_force {
+	int    num_paths;
+	char   paths[MAX_BRUTE_PATHS][64];
+	int    cost[MAX_BRUTE_PATHS];
+};
+
+/* Every simple path from 'path[len - 1]' on, by the rules of ksp.c: nothing
+   goes into a source or out of a target, and excluded nodes are left out.
+*/
+static void all_paths( const struct small_network * small, int * path, int len, int * on_path,
+                       struct brute_force * brute )
+{
+	char * text;
+	int    used;
+	int    u;
+	int    v;
+	int    i;
+
+	u = path[len - 1];
+
+	if (small->role[u] == ROLE_TARGET) {
+		if (brute->num_paths == MAX_BRUTE_PATHS)
+			return;
+
+		text = brute->paths[brute->num_paths];
+		used = 0;
+
+		for (i = 0; i < len; i++)
+			used += sprintf( text + used, "%sN%d", (i > 0) ? "|" : "", path[i] );
+
+		brute->cost[brute->num_paths++] = len - 1;
+		return;
+	}
+
+	for (v = 0; v < small->num_nodes; v++) {
+		if (!small->adj[u][v] || on_path[v] || v == small->excluded || small->role[v] == ROLE_SOURCE)
+			continue;
+
+		on_path[v] = TRUE;
+		path[len] = v;
+		all_paths( small, path, len + 1, on_path, brute );
+		on_path[v] = FALSE;
+	}
+}
+
+static int compare_names( const void * a, const void * b ) {
+	return strcmp( (const char *) a, (const char *) b );
+}
+
+static void check_ksp_all( const char * dir ) {
+	static struct brute_force brute;
+	static char found[MAX_BRUTE_PATHS][64];
+	struct small_network small;
+	struct network net;
+	struct report report;
+	struct run_files files;
+	struct run run;
+	char   net_name[4096];
+	char   in_name[4096];
+	int    path[MAX_SMALL_NODES];
+	int    on_path[MAX_SMALL_NODES];
+	int    ok;
+	int    n;
+	int    i;
+
+	snprintf( net_name, sizeof( net_name ), "%s/small.cyjs", dir );
+	snprintf( in_name, sizeof( in_name ), "%s/small_in.txt", dir );
+	rng_state = 0x9e3779b97f4a7c15ULL;
+	ok = TRUE;
+
+	for (n = 0; n < SMALL_NETWORKS && ok; n++) {
+		make_small_network( &small );
+
+		brute.num_paths = 0;
+		memset( on_path, 0, sizeof( on_path ) );
+
+		for (i = 0; i < small.num_nodes; i++) {
+			if (small.role[i] == ROLE_SOURCE) {
+				path[0] = i;
+				on_path[i] = TRUE;
+				all_paths( &small, path, 1, on_path, &brute );
+				on_path[i] = FALSE;
+			}
+		}
+
+		/* the network is written anew each time, so no snapshot of an older
+		   one may stand in for it */
+		unlink( net_name );
+		strcat( net_name, ".snap" );
+		unlink( net_name );
+		net_name[strlen( net_name ) - 5] = '\0';
+
+		if (write_small_network( &small, net_name, in_name ) != 0) {
+			fail( "ksp_all", "could not write '%s'", net_name );
+			return;
+		}
+
+		begin_report( &report );
+
+		if (open_network( net_name, &net, 1, &report ) != 0) {
+			fail( "ksp_all", "could not open '%s'", net_name );
+			end_report( &report, 0, NULL );
+			return;
+		}
+
+		end_report( &report, 0, NULL );
+
+		if (start_run( &run, &net, &files, in_name ) != 0 || find_shortest_paths( &run, MAX_BRUTE_PATHS ) != 0) {
+			fail( "ksp_all", "network %d: the search failed", n );
+			free_network( &net );
+			return;
+		}
+
+		if (run.paths.num_paths != brute.num_paths) {
+			fail( "ksp_all", "network %d: %d paths instead of %d", n, run.paths.num_paths, brute.num_paths );
+			ok = FALSE;
+		}
+
+		for (i = 0; i < run.paths.num_paths && ok; i++) {
+			path_names( &run, i, found[i], sizeof( found[i] ) );
+
+			/* shortest first, and a path costs its number of edges */
+			if (i > 0 && run.paths.cost[i] < run.paths.cost[i - 1]) {
+				fail( "ksp_all", "network %d: path %d is shorter than the one before", n, i + 1 );
+				ok = FALSE;
+			}
+
+			if (run.paths.cost[i] != run.paths.path_start[i + 1] - run.paths.path_start[i] - 1) {
+				fail( "ksp_all", "network %d: path %s costs %g", n, found[i], run.paths.cost[i] );
+				ok = FALSE;
+			}
+		}
+
+		if (ok) {
+			qsort( found, run.paths.num_paths, sizeof( found[0] ), compare_names );
+			qsort( brute.paths, brute.num_paths, sizeof( brute.paths[0] ), compare_names );
+
+			for (i = 0; i < brute.num_paths && ok; i++) {
+				if (strcmp( found[i], brute.paths[i] ) != 0) {
+					fail( "ksp_all", "network %d: found %s where brute force has %s", n, found[i], brute.paths[i] );
+					ok = FALSE;
+				}
+			}
+		}
+
+		end_run( &run );
+		free_network( &net );
+	}
+
+	unlink( net_name );
+	unlink( in_name );
+	strcat( net_name, ".snap" );
+	unlink( net_name );
+
+	if (ok)
+		passed( "ksp_all" );
+}
+
+static void check_load( const char * net_name, int num_threads ) {
+	struct network serial;
+	struct network parallel;
+	struct report report;
+	struct stat st;
+	int    ret;
+
+	begin_report( &report );
+
+	/* load_network() doesn't look at or make snapshots */
+	ret = load_network( net_name, &serial, NULL, 1, &report );
+
+	if (ret == 0)
+		ret = load_network( net_name, &parallel, NULL, num_threads, &report );
+	else
+		init_network( &parallel );
+
+	if (ret != 0)
+		fail( "load", "could not load '%s': %s", net_name, last_out_message( &report ) );
+	else if (stat( net_name, &st ) != 0 || st.st_size < (8 << 20))
+		fail( "load", "'%s' is too small to be parsed on several threads", net_name );
+	else if (same_networks( "load", &serial, &parallel ))
+		passed( "load" );
+
+	free_network( &serial );
+	free_network( &parallel );
+	end_report( &report, 0, NULL );
+}
+
+/* Open the network from its .cyjs file into 'fresh', which is kept for the
+   other checks, and again from the snapshot that made.
+*/
+static int check_snapshot( const char * net_name, struct network * fresh, int num_threads ) {
+	struct network snap;
+	struct report report;
+	char   snap_name[4096];
+	char   name[4096];
+	const struct str_view * view;
+	int    ok;
+	int    i;
+
+	if (snprintf( snap_name, sizeof( snap_name ), "%s.snap", net_name ) >= (int) sizeof( snap_name )) {
+		fail( "snapshot", "'%s' is too long a name", net_name );
+		return -1;
+	}
+
+	unlink( snap_name );
+	begin_report( &report );
+
+	if (open_network( net_name, fresh, num_threads, &report ) != 0) {
+		fail( "snapshot", "could not open '%s': %s", net_name, last_out_message( &report ) );
+		end_report( &report, 0, NULL );
+		return -1;
+	}
+
+	if (open_network( net_name, &snap, num_threads, &report ) != 0) {
+		fail( "snapshot", "could not open '%s' again", net_name );
+		end_report( &report, 0, NULL );
+		return 0;
+	}
+
+	end_report( &report, 0, NULL );
+	ok = TRUE;
+
+	if (snap.snapshot.data == NULL) {
+		fail( "snapshot", "'%s' wasn't opened from its snapshot", net_name );
+		ok = FALSE;
+	}
+	else if (!same_networks( "snapshot", fresh, &snap ))
+		ok = FALSE;
+
+	/* and the lookup tables that came with it */
+	for (i = 0; i < fresh->num_nodes && ok; i++) {
+		view = &fresh->node_name[i];
+
+		if (view->len >= sizeof( name ))
+			continue;
+
+		memcpy( name, fresh->text + view->off, view->len );
+		name[view->len] = '\0';
+
+		if (lookup_node( &fresh->index, name ) != lookup_node( &snap.index, name )) {
+			fail( "snapshot", "node '%s' is looked up differently", name );
+			ok = FALSE;
+		}
+	}
+
+	for (i = 0; i < fresh->num_edges && ok; i++) {
+		if (find_edge( &fresh->adj, fresh->edge_source[i], fresh->edge_target[i] ) !=
+		    find_edge( &snap.adj, fresh->edge_source[i], fresh->edge_target[i] ))
+		{
+			fail( "snapshot", "edge %d is found differently", i );
+			ok = FALSE;
+		}
+	}
+
+	if (ok)
+		passed( "snapshot" );
+
+	free_network( &snap );
+	return 0;
+}
+
+static void check_flag( struct network * net, const char * in_name, const char * paths_name, int num_threads ) {
+	struct run_files files[2];
+	struct run run[2];
+	int    ok;
+	int    i;
+
+	if (start_run( &run[0], net, &files[0], in_name ) != 0) {
+		fail( "flag", "could not start the runs" );
+		return;
+	}
+
+	if (start_run( &run[1], net, &files[1], in_name ) != 0) {
+		fail( "flag", "could not start the runs" );
+		end_run( &run[0] );
+		return;
+	}
+
+	ok = (load_out_paths( &run[0], paths_name ) == 0 && load_out_paths( &run[1], paths_name ) == 0 &&
+	      flag_nodes_and_edges( &run[0], 0, 1 ) == 0 && flag_nodes_and_edges( &run[1], 0, num_threads ) == 0);
+
+	if (!ok)
+		fail( "flag", "could not flag the paths of '%s'", paths_name );
+	else if (run[0].paths.num_pairs < 4 * 4096)
+		fail( "flag", "%d hop pairs are too few to be flagged on several threads", run[0].paths.num_pairs );
+	else {
+		if (memcmp( run[0].node_output, run[1].node_output, BIT_WORDS( net->num_nodes ) * sizeof( unsigned int ) ) != 0) {
+			fail( "flag", "different nodes are flagged" );
+			ok = FALSE;
+		}
+
+		if (memcmp( run[0].edge_output, run[1].edge_output, BIT_WORDS( net->num_edges ) * sizeof( unsigned int ) ) != 0) {
+			fail( "flag", "different edges are flagged" );
+			ok = FALSE;
+		}
+
+		for (i = 0; i < run[0].paths.num_pairs && ok; i++) {
+			if (run[0].paths.pair_edge[i] != run[1].paths.pair_edge[i]) {
+				fail( "flag", "hop pair %d has edge %d instead of %d", i, run[1].paths.pair_edge[i],
+				      run[0].paths.pair_edge[i] );
+				ok = FALSE;
+			}
+		}
+
+		if (ok)
+			passed( "flag" );
+	}
+
+	end_run( &run[0] );
+	end_run( &run[1] );
+}
+
+/* Make a run of 'net' with the paths of the first 'lines' lines of the paths
+   file 'paths_name', or with the 'k1' shortest paths if there is no paths
+   file, extend it with the rest or to 'k2' paths, and compare what it wrote
+   with what a run made with them all at once writes. Both reports start
+   with a line from run.py, which has to be left alone.
+*/
+static int extend_matches( const char * check, struct network * net, const char * dir, const char * in_name,
+                           const char * paths_name, int lines, int k1, int k2 )
+{
+	static const char run_py_line[] = "a line from run.py\n";
+	struct run_files files[2];
+	struct run_options options;
+	struct mapped_file paths;
+	struct run run;
+	char   names[5][4096];
+	size_t split;
+	int    ok;
+	int    i;
+
+	snprintf( names[0], sizeof( names[0] ), "%s/extend_all.cyjs", dir );
+	snprintf( names[1], sizeof( names[1] ), "%s/extend_all.txt", dir );
+	snprintf( names[2], sizeof( names[2] ), "%s/extend.cyjs", dir );
+	snprintf( names[3], sizeof( names[3] ), "%s/extend.txt", dir );
+	snprintf( names[4], sizeof( names[4] ), "%s/extend_paths.txt", dir );
+
+	for (i = 0; i < 2; i++) {
+		default_run_files( &files[i], (paths_name != NULL) ? ((i == 0) ? paths_name : names[4]) : NULL );
+		files[i].in_txt = in_name;
+		files[i].out_cyjs = names[2 * i];
+		files[i].out_txt = names[2 * i + 1];
+
+		if (put_file( files[i].out_txt, "w", run_py_line, strlen( run_py_line ) ) != 0) {
+			fail( check, "could not write '%s'", files[i].out_txt );
+			return FALSE;
+		}
+	}
+
+	paths.data = NULL;
+	split = 0;
+
+	if (paths_name != NULL) {
+		if (map_file( paths_name, &paths ) != 0) {
+			fail( check, "could not read '%s'", paths_name );
+			return FALSE;
+		}
+
+		for (i = 0; i < lines && split < paths.size; split++)
+			if (paths.data[split] == '\n')
+				i++;
+
+		if (put_file( names[4], "w", paths.data, split ) != 0) {
+			fail( check, "could not write '%s'", names[4] );
+			unmap_file( &paths );
+			return FALSE;
+		}
+	}
+
+	default_run_options( &options );
+	options.ksp_paths = (paths_name != NULL) ? 0 : k2;
+	ok = (post_run_py_network( &run, net, &files[0], &options ) == 0);
+	release_run( &run );
+
+	if (ok) {
+		options.ksp_paths = (paths_name != NULL) ? 0 : k1;
+		ok = (post_run_py_network( &run, net, &files[1], &options ) == 0);
+
+		if (ok && paths_name != NULL)
+			ok = (put_file( names[4], "a", paths.data + split, paths.size - split ) == 0);
+
+		options.ksp_paths = (paths_name != NULL) ? 0 : k2;
+
+		if (ok)
+			ok = (post_run_py_extend( &run, &options ) == 0);
+
+		release_run( &run );
+	}
+
+	if (paths_name != NULL)
+		unmap_file( &paths );
+
+	if (!ok) {
+		fail( check, "the runs failed" );
+		return FALSE;
+	}
+
+	ok = same_files( check, names[0], names[2] ) && same_files( check, names[1], names[3] );
+
+	for (i = 0; i < 5; i++)
+		unlink( names[i] );
+
+	return ok;
+}
+
+static void check_extend( const char * dir, struct network * net, const char * in_name, const char * paths_name ) {
+	struct network ksp_net;
+	struct report report;
+	char   net_name[4096];
+	char   ksp_in_name[4096];
+	int    ok;
+
+	snprintf( net_name, sizeof( net_name ), "%s/ksp.cyjs", dir );
+	snprintf( ksp_in_name, sizeof( ksp_in_name ), "%s/ksp_in.txt", dir );
+	begin_report( &report );
+
+	if (open_network( net_name, &ksp_net, 1, &report ) != 0) {
+		fail( "extend", "could not open '%s'", net_name );
+		end_report( &report, 0, NULL );
+		return;
+	}
+
+	end_report( &report, 0, NULL );
+
+	ok = extend_matches( "extend", &ksp_net, dir, ksp_in_name, NULL, 0, 2, 10 );
+	free_network( &ksp_net );
+
+	if (ok)
+		ok = extend_matches( "extend", net, dir, in_name, paths_name, 1000, 0, 0 );
+
+	if (ok)
+		passed( "extend" );
+}
+
+static void print_usage( void ) {
+	printf( "Usage: run_checks [-t <threads>] <dir>\n\n" );
+	printf( "where <dir> holds the fixtures and the 'net.cyjs', 'in.txt' and 'paths.txt' made by gen_network.\n" );
+}
+
+int main( int argc, char ** argv ) {
+	struct network net;
+	char   names[3][4096];
+	const char * dir;
+	int    num_threads;
+	int    opt;
+
+	num_threads = 4;
+
+	while ((opt = getopt( argc, argv, "t:" )) != -1) {
+		switch (opt) {
+		case 't': num_threads = atoi( optarg ); break;
+		default: print_usage(); return 1;
+		}
+	}
+
+	if (optind != argc - 1 || num_threads < 2) {
+		print_usage();
+		return 1;
+	}
+
+	dir = argv[optind];
+	snprintf( names[0], sizeof( names[0] ), "%s/net.cyjs", dir );
+	snprintf( names[1], sizeof( names[1] ), "%s/in.txt", dir );
+	snprintf( names[2], sizeof( names[2] ), "%s/paths.txt", dir );
+
+	/* the library's progress messages go to stdout, before the results */
+	setvbuf( stdout, NULL, _IOLBF, 0 );
+
+	check_ksp( dir );
+	check_missing( dir );
+	check_ksp_all( dir );
+	check_load( names[0], num_threads );
+
+	if (check_snapshot( names[0], &net, num_threads ) == 0) {
+		check_flag( &net, names[1], names[2], num_threads );
+		check_extend( dir, &net, names[1], names[2] );
+		free_network( &net );
+	}
+
+	if (failures > 0) {
+		printf( "check: %d failed\n", failures );
+		return 1;
+	}
+
+	printf( "check: all passed\n" );
+	return 0;
+}
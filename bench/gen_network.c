@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* gen_network.c
+
+   Makes a synthetic network to benchmark post_run_py against: a .cyjs file
+   laid out the way Cytoscape writes it, an 'in.txt' and a paths file in the
+   format of PathLinker's 'run.py'. The paths are random walks along the
+   edges, so their hops are all found in the network, and the sources and
+   targets in 'in.txt' are where some of them start and end. The same seed
+   always gives the same files.
+
+   Usage: gen_network <dir> <nodes> <edges> <paths> <max hops> [<seed>]
+*/
+
+#define  MAX_IN_NODES             (100)
+
+static const char * layers[] = { "Receptor", "TF", "Kinase", "Ligand" };
+static const char * interactions[] = { "activation", "inhibition", "binding", "phosphorylation" };
+static const char * times[] = { "T1", "T2", "T1, T3", "T4 late" };
+
+static unsigned long long rng_state;
+
+/* xorshift64*, so the files don't depend on the C library's rand() */
+static unsigned long long next_random( void ) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 2685821657736338717ULL;
+}
+
+static long random_below( long n ) {
+	return (long) (next_random() % (unsigned long long) n);
+}
+
+static double random_between( double lo, double hi ) {
+	return lo + (hi - lo) * (double) (next_random() >> 11) / 9007199254740992.0;
+}
+
+static FILE * open_file( const char * dir, const char * name ) {
+	char   path[4096];
+	FILE * f;
+
+	snprintf( path, sizeof( path ), "%s/%s", dir, name );
+	f = fopen( path, "w" );
+
+	if (f == NULL) {
+		printf( "unable to create '%s'\n", path );
+		exit( 1 );
+	}
+
+	setvbuf( f, NULL, _IOFBF, 1 << 20 );
+	return f;
+}
+
+static void close_file( FILE * f, const char * name ) {
+	if (ferror( f ) || fclose( f ) != 0) {
+		printf( "could not write '%s'\n", name );
+		exit( 1 );
+	}
+}
+
+static void write_network( const char * dir, long num_nodes, long num_edges, const long * edge_source,
+                           const long * edge_target )
+{
+	FILE * f;
+	long   i;
+
+	f = open_file( dir, "net.cyjs" );
+
+	fprintf( f, "{\n  \"format_version\" : \"1.0\",\n  \"generated_by\" : \"gen_network\",\n" );
+	fprintf( f, "  \"target_cytoscapejs_version\" : \"~2.1\",\n  \"data\" : {\n" );
+	fprintf( f, "    \"shared_name\" : \"bench\",\n    \"name\" : \"bench\",\n    \"SUID\" : 52,\n" );
+	fprintf( f, "    \"__Annotations\" : [ ],\n    \"selected\" : true\n  },\n" );
+	fprintf( f, "  \"elements\" : {\n    \"nodes\" : [ " );
+
+	for (i = 0; i < num_nodes; i++) {
+		fprintf( f, "%s{\n      \"data\" : {\n", (i > 0) ? "}, " : "" );
+		fprintf( f, "        \"id\" : \"%ld\",\n", 100 + i );
+		fprintf( f, "        \"shared_name\" : \"G%ld\",\n", i );
+		fprintf( f, "        \"isExcludedFromPaths\" : false,\n" );
+		fprintf( f, "        \"name\" : \"G%ld\",\n", i );
+		fprintf( f, "        \"isInPath\" : false,\n" );
+		fprintf( f, "        \"FoldChange\" : %.4f,\n", random_between( -3.0, 3.0 ) );
+		fprintf( f, "        \"SUID\" : %ld,\n", 100 + i );
+		fprintf( f, "        \"Layer\" : \"%s\",\n", layers[i % 4] );
+		fprintf( f, "        \"Prize\" : %ld,\n", i % 5 );
+		fprintf( f, "        \"selected\" : false\n      },\n" );
+		fprintf( f, "      \"position\" : {\n        \"x\" : %.3f,\n        \"y\" : %.3f\n      },\n",
+		         random_between( -5000.0, 5000.0 ), random_between( -5000.0, 5000.0 ) );
+		fprintf( f, "      \"selected\" : false\n    " );
+	}
+
+	fprintf( f, "} ],\n    \"edges\" : [ " );
+
+	for (i = 0; i < num_edges; i++) {
+		fprintf( f, "%s{\n      \"data\" : {\n", (i > 0) ? "}, " : "" );
+		fprintf( f, "        \"id\" : \"%ld\",\n", 100 + num_nodes + i );
+		fprintf( f, "        \"source\" : \"%ld\",\n", 100 + edge_source[i] );
+		fprintf( f, "        \"target\" : \"%ld\",\n", 100 + edge_target[i] );
+		fprintf( f, "        \"shared_name\" : \"G%ld (%s) G%ld\",\n", edge_source[i], interactions[i % 4], edge_target[i] );
+		fprintf( f, "        \"sh_interaction\" : \"%s\",\n", interactions[i % 4] );
+		fprintf( f, "        \"name\" : \"G%ld (%s) G%ld\",\n", edge_source[i], interactions[i % 4], edge_target[i] );
+		fprintf( f, "        \"interaction\" : \"%s\",\n", interactions[i % 4] );
+		fprintf( f, "        \"isInPath\" : false,\n" );
+		fprintf( f, "        \"SUID\" : %ld,\n", 100 + num_nodes + i );
+		fprintf( f, "        \"Time\" : \"%s\",\n", times[i % 4] );
+		fprintf( f, "        \"selected\" : false\n      },\n" );
+		fprintf( f, "      \"selected\" : false\n    " );
+	}
+
+	fprintf( f, "} ]\n  }\n}\n" );
+
+	close_file( f, "net.cyjs" );
+}
+
+int main( int argc, char ** argv ) {
+	const char * dir;
+	long   num_nodes;
+	long   num_edges;
+	long   num_paths;
+	long   max_hops;
+	long * edge_source;
+	long * edge_target;
+	long * row_start;
+	long * col_target;
+	long * path;
+	long * row_fill;
+	long   hops;
+	long   node;
+	long   i;
+	long   j;
+	int    num_sources;
+	int    num_targets;
+	long   sources[MAX_IN_NODES];
+	long   targets[MAX_IN_NODES];
+	FILE * f;
+
+	if (argc != 6 && argc != 7) {
+		printf( "Usage: gen_network <dir> <nodes> <edges> <paths> <max hops> [<seed>]\n" );
+		return 1;
+	}
+
+	dir = argv[1];
+	num_nodes = atol( argv[2] );
+	num_edges = atol( argv[3] );
+	num_paths = atol( argv[4] );
+	max_hops = atol( argv[5] );
+	rng_state = (argc == 7) ? strtoull( argv[6], NULL, 10 ) : 1;
+
+	if (num_nodes < 2 || num_edges < 1 || num_paths < 0 || max_hops < 1) {
+		printf( "need at least 2 nodes, 1 edge and 1 hop\n" );
+		return 1;
+	}
+
+	/* a zero state would stay zero */
+	rng_state = rng_state * 0x9e3779b97f4a7c15ULL + 1;
+
+	edge_source = (long *) malloc( num_edges * sizeof( long ) );
+	edge_target = (long *) malloc( num_edges * sizeof( long ) );
+	row_start = (long *) calloc( num_nodes + 1, sizeof( long ) );
+	col_target = (long *) malloc( num_edges * sizeof( long ) );
+	path = (long *) malloc( (max_hops + 1) * sizeof( long ) );
+	row_fill = (long *) malloc( num_nodes * sizeof( long ) );
+
+	if (edge_source == NULL || edge_target == NULL || row_start == NULL || col_target == NULL ||
+	    path == NULL || row_fill == NULL)
+	{
+		printf( "out of memory\n" );
+		return 1;
+	}
+
+	for (i = 0; i < num_edges; i++) {
+		edge_source[i] = random_below( num_nodes );
+
+		do
+			edge_target[i] = random_below( num_nodes );
+		while (edge_target[i] == edge_source[i]);
+
+		row_start[edge_source[i] + 1]++;
+	}
+
+	write_network( dir, num_nodes, num_edges, edge_source, edge_target );
+
+	/* out-edges by node, for the walks */
+	for (i = 0; i < num_nodes; i++)
+		row_start[i + 1] += row_start[i];
+
+	/* each row is filled from its end back */
+	for (i = 0; i < num_nodes; i++)
+		row_fill[i] = row_start[i + 1];
+
+	for (i = 0; i < num_edges; i++)
+		col_target[--row_fill[edge_source[i]]] = edge_target[i];
+
+	f = open_file( dir, "paths.txt" );
+	fprintf( f, "#KSP\tpath_length\tpath\n" );
+
+	num_sources = 0;
+	num_targets = 0;
+
+	for (i = 0; i < num_paths; ) {
+		path[0] = random_below( num_nodes );
+		hops = 1 + random_below( max_hops );
+
+		for (j = 0; j < hops; j++) {
+			node = path[j];
+
+			if (row_start[node + 1] == row_start[node])
+				break;
+
+			path[j + 1] = col_target[row_start[node] + random_below( row_start[node + 1] - row_start[node] )];
+		}
+
+		if (j == 0)
+			continue;
+
+		fprintf( f, "%ld\t%ld\t", ++i, j );
+
+		for (hops = 0; hops <= j; hops++)
+			fprintf( f, "%sG%ld", (hops > 0) ? "|" : "", path[hops] );
+
+		fputc( '\n', f );
+
+		if (num_sources < MAX_IN_NODES)
+			sources[num_sources++] = path[0];
+
+		if (num_targets < MAX_IN_NODES)
+			targets[num_targets++] = path[j];
+	}
+
+	close_file( f, "paths.txt" );
+
+	f = open_file( dir, "in.txt" );
+	fprintf( f, "#node\tnode_symbol\n" );
+
+	for (j = 0; j < num_sources; j++)
+		fprintf( f, "G%ld\tsource\n", sources[j] );
+
+	for (j = 0; j < num_targets; j++)
+		fprintf( f, "G%ld\ttarget\n", targets[j] );
+
+	close_file( f, "in.txt" );
+
+	printf( "gen_network: %ld nodes, %ld edges and %ld paths in '%s'\n", num_nodes, num_edges, num_paths, dir );
+
+	free( edge_source );
+	free( edge_target );
+	free( row_start );
+	free( col_target );
+	free( path );
+	free( row_fill );
+
+	return 0;
+}
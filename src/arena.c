@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "post_run_py.h"
+
+/* arena.c
+
+   A bump allocator for everything that lives exactly as long as one run of
+   post_run_py: the node and edge records, the detected paths and the lookup
+   tables built over them. Memory is taken from the system in large chunks
+   and handed out in order, and the whole lot is given back in one go by
+   arena_release().
+*/
+
+#define  ARENA_CHUNK_SIZE         (1 << 20)
+#define  ARENA_ALIGN              (16)
+
+struct arena_chunk {
+	struct arena_chunk * prev;
+	size_t size;
+	size_t used;
+	/* keeps the data that follows aligned */
+	double align;
+};
+
+void arena_init( struct arena * arena ) {
+	arena->last = NULL;
+	arena->allocated = 0;
+	arena->chunks = 0;
+}
+
+/* Get 'size' bytes from the arena, or NULL if the system is out of memory.
+   Requests bigger than a chunk get a chunk of their own.
+*/
+void * arena_alloc( struct arena * arena, size_t size ) {
+	struct arena_chunk * chunk;
+	size_t chunk_size;
+	void * ptr;
+
+	size = (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+	chunk = arena->last;
+
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		chunk_size = (size > ARENA_CHUNK_SIZE) ? size : ARENA_CHUNK_SIZE;
+		chunk = (struct arena_chunk *) malloc( sizeof( struct arena_chunk ) + chunk_size );
+
+		if (chunk == NULL)
+			return NULL;
+
+		chunk->size = chunk_size;
+		chunk->used = 0;
+
+		/* an oversized chunk goes behind the current one so that the rest of
+		   the current one can still be used */
+		if (chunk_size > ARENA_CHUNK_SIZE && arena->last != NULL) {
+			chunk->prev = arena->last->prev;
+			arena->last->prev = chunk;
+		}
+		else {
+			chunk->prev = arena->last;
+			arena->last = chunk;
+		}
+
+		arena->allocated += chunk_size;
+		arena->chunks += 1;
+	}
+
+	ptr = (char *) (chunk + 1) + chunk->used;
+	chunk->used += size;
+
+	return ptr;
+}
+
+void * arena_calloc( struct arena * arena, size_t count, size_t size ) {
+	void * ptr;
+
+	if (size != 0 && count > (size_t) -1 / size)
+		return NULL;
+
+	ptr = arena_alloc( arena, count * size );
+
+	if (ptr != NULL)
+		memset( ptr, 0, count * size );
+
+	return ptr;
+}
+
+/* Free everything that was ever allocated from the arena.
+*/
+void arena_release( struct arena * arena ) {
+	struct arena_chunk * chunk;
+	struct arena_chunk * prev;
+
+	for (chunk = arena->last; chunk != NULL; chunk = prev) {
+		prev = chunk->prev;
+		free( chunk );
+	}
+
+	arena_init( arena );
+}
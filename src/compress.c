@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "post_run_py.h"
+
+/* compress.c
+
+   Compressed network files. A gzip or zstd file is recognized by its first
+   bytes, whatever it is called, and decompressed into memory in one go, so
+   the parser still gets the whole text in one piece to keep views into. An
+   output file named *.gz (or *.zst) is compressed on its way out.
+
+   zstd is only there when built with HAVE_ZSTD defined and linked against
+   libzstd. Without it a zstd file can't be read, nor a *.zst file written.
+*/
+
+/* Output is mostly the same keys over and over, which even the fastest
+   level squeezes well. */
+#define  GZIP_LEVEL               (1)
+#define  ZSTD_LEVEL               (3)
+
+#define  ENCODE_CHUNK             (256 * 1024)
+
+/* The size a compressed file gives for its content comes from the file, so
+   the first buffer is never more than this many times the file's size; if
+   the content really is bigger, the buffer grows as it comes. */
+#define  MAX_GUESS_RATIO          (32)
+
+static const unsigned char gzip_magic[] = { 0x1f, 0x8b };
+static const unsigned char zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+static int has_magic( const struct mapped_file * file, const unsigned char * magic, size_t len ) {
+	return file->size >= len && memcmp( file->data, magic, len ) == 0;
+}
+
+static int has_suffix( const char * file_name, const char * suffix ) {
+	size_t len = strlen( file_name );
+	size_t suffix_len = strlen( suffix );
+
+	return len > suffix_len && strcmp( file_name + len - suffix_len, suffix ) == 0;
+}
+
+/* Grow a decompression buffer to at least 'need' bytes. */
+static int grow_buffer( char ** buf, size_t * cap, size_t need ) {
+	char * grown;
+	size_t cap2;
+
+	for (cap2 = (*cap > 0) ? *cap : 65536; cap2 < need; cap2 *= 2)
+		;
+
+	if (cap2 == *cap)
+		return 0;
+
+	grown = (char *) realloc( *buf, cap2 );
+
+	if (grown == NULL)
+		return -1;
+
+	*buf = grown;
+	*cap = cap2;
+	return 0;
+}
+
+/* Inflate every member of a gzip file. The size of the last member, mod 4G,
+   is at the end of the file, which makes a good first guess at the size. */
+static int inflate_gzip( const struct mapped_file * file, char ** out, size_t * out_size ) {
+	const unsigned char * tail;
+	z_stream zs;
+	char * buf;
+	size_t cap;
+	size_t len;
+	size_t pos;
+	int    ret;
+
+	cap = file->size * 4;
+
+	/* a header and a trailer at least */
+	if (file->size >= 18) {
+		tail = (const unsigned char *) file->data + file->size - 4;
+		len = ((size_t) tail[0] | (size_t) tail[1] << 8 | (size_t) tail[2] << 16 | (size_t) tail[3] << 24) + 1;
+
+		if (len >= file->size)
+			cap = (len < file->size * MAX_GUESS_RATIO) ? len : file->size * MAX_GUESS_RATIO;
+	}
+
+	buf = (char *) malloc( cap );
+	memset( &zs, 0, sizeof( zs ) );
+
+	if (buf == NULL || inflateInit2( &zs, 15 + 16 ) != Z_OK) {
+		free( buf );
+		return -1;
+	}
+
+	len = 0;
+	pos = 0;
+
+	for (;;) {
+		if (len == cap && grow_buffer( &buf, &cap, cap + 1 ) != 0) {
+			ret = Z_MEM_ERROR;
+			break;
+		}
+
+		/* the counts are only 32 bits */
+		zs.next_in = (unsigned char *) file->data + pos;
+		zs.avail_in = (uInt) ((file->size - pos > (1u << 30)) ? (1u << 30) : file->size - pos);
+		zs.next_out = (unsigned char *) buf + len;
+		zs.avail_out = (uInt) ((cap - len > (1u << 30)) ? (1u << 30) : cap - len);
+
+		ret = inflate( &zs, Z_NO_FLUSH );
+		pos = (char *) zs.next_in - file->data;
+		len = (char *) zs.next_out - buf;
+
+		if (ret == Z_STREAM_END) {
+			if (pos == file->size)
+				break;
+
+			/* the next member of a file made by concatenating gzip files */
+			if (inflateReset( &zs ) != Z_OK)
+				break;
+		}
+		else if (ret != Z_OK && !(ret == Z_BUF_ERROR && len == cap))
+			break;
+	}
+
+	inflateEnd( &zs );
+
+	if (ret != Z_STREAM_END || pos != file->size) {
+		free( buf );
+		return -1;
+	}
+
+	*out = buf;
+	*out_size = len;
+	return 0;
+}
+
+#ifdef HAVE_ZSTD
+static int decompress_zstd( const struct mapped_file * file, char ** out, size_t * out_size ) {
+	ZSTD_DStream * zs;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer dst;
+	unsigned long long hint;
+	char * buf;
+	size_t cap;
+	size_t ret;
+
+	hint = ZSTD_getFrameContentSize( file->data, file->size );
+	cap = file->size * 4;
+
+	if (hint != ZSTD_CONTENTSIZE_UNKNOWN && hint != ZSTD_CONTENTSIZE_ERROR)
+		cap = (hint < (unsigned long long) file->size * MAX_GUESS_RATIO) ? (size_t) hint + 1 : file->size * MAX_GUESS_RATIO;
+
+	buf = (char *) malloc( cap );
+	zs = ZSTD_createDStream();
+
+	if (buf == NULL || zs == NULL) {
+		free( buf );
+		ZSTD_freeDStream( zs );
+		return -1;
+	}
+
+	in.src = file->data;
+	in.size = file->size;
+	in.pos = 0;
+	dst.pos = 0;
+	ret = 1;
+
+	/* a full buffer may still have more to come after the last input */
+	while (in.pos < in.size || (ret != 0 && dst.pos == cap)) {
+		if (dst.pos == cap && grow_buffer( &buf, &cap, cap + 1 ) != 0)
+			break;
+
+		dst.dst = buf;
+		dst.size = cap;
+		ret = ZSTD_decompressStream( zs, &dst, &in );
+
+		if (ZSTD_isError( ret ))
+			break;
+	}
+
+	ZSTD_freeDStream( zs );
+
+	/* 0 once the last frame is complete */
+	if (ret != 0) {
+		free( buf );
+		return -1;
+	}
+
+	*out = buf;
+	*out_size = dst.pos;
+	return 0;
+}
+#endif
+
+/* If the mapped 'file' is compressed, replace the mapping with its
+   decompressed contents. Returns -1 if it can't be decompressed.
+*/
+int decompress_file( struct mapped_file * file ) {
+	char * data;
+	size_t size;
+	int    ret;
+
+	if (has_magic( file, gzip_magic, sizeof( gzip_magic ) ))
+		ret = inflate_gzip( file, &data, &size );
+	else if (has_magic( file, zstd_magic, sizeof( zstd_magic ) )) {
+#ifdef HAVE_ZSTD
+		ret = decompress_zstd( file, &data, &size );
+#else
+		printf( "zstd compressed files aren't supported by this build.\n" );
+		ret = -1;
+#endif
+	}
+	else
+		return 0;
+
+	if (ret != 0)
+		return -1;
+
+	unmap_file( file );
+	file->data = data;
+	file->size = size;
+	file->allocated = TRUE;
+
+	return 0;
+}
+
+/* The compression an output file gets from its name. */
+int output_compression( const char * file_name ) {
+	if (has_suffix( file_name, ".gz" ))
+		return COMPRESS_GZIP;
+
+	if (has_suffix( file_name, ".zst" ))
+		return COMPRESS_ZSTD;
+
+	return COMPRESS_NONE;
+}
+
+static int write_fd( int fd, const char * buf, size_t len ) {
+	ssize_t n;
+
+	while (len > 0) {
+		n = write( fd, buf, len );
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return -1;
+		}
+
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* Write what the encoder has made to its file, counting it. */
+static int encoder_output( struct encoder * enc, const char * buf, size_t len ) {
+	enc->bytes_written += len;
+	return write_fd( enc->fd, buf, len );
+}
+
+int encoder_open( struct encoder * enc, int type, int fd ) {
+	z_stream * zs;
+
+	enc->type = type;
+	enc->fd = fd;
+	enc->failed = FALSE;
+	enc->bytes_written = 0;
+	enc->state = NULL;
+	enc->chunk = NULL;
+
+	if (type == COMPRESS_NONE)
+		return 0;
+
+#ifndef HAVE_ZSTD
+	/* rather than plain text under a .zst name */
+	if (type == COMPRESS_ZSTD) {
+		printf( "zstd compressed files aren't supported by this build.\n" );
+		return -1;
+	}
+#endif
+
+	enc->chunk = (char *) malloc( ENCODE_CHUNK );
+
+	if (enc->chunk == NULL)
+		return -1;
+
+	if (type == COMPRESS_GZIP) {
+		zs = (z_stream *) calloc( 1, sizeof( z_stream ) );
+
+		if (zs == NULL || deflateInit2( zs, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) != Z_OK) {
+			free( zs );
+			free( enc->chunk );
+			return -1;
+		}
+
+		enc->state = zs;
+	}
+#ifdef HAVE_ZSTD
+	else {
+		enc->state = ZSTD_createCStream();
+
+		if (enc->state == NULL || ZSTD_isError( ZSTD_initCStream( enc->state, ZSTD_LEVEL ) )) {
+			ZSTD_freeCStream( enc->state );
+			free( enc->chunk );
+			return -1;
+		}
+	}
+#endif
+
+	return 0;
+}
+
+static void deflate_chunk( struct encoder * enc, const char * data, size_t len, int flush ) {
+	z_stream * zs = enc->state;
+	int    ret;
+
+	zs->next_in = (unsigned char *) data;
+	zs->avail_in = (uInt) len;
+
+	do {
+		zs->next_out = (unsigned char *) enc->chunk;
+		zs->avail_out = ENCODE_CHUNK;
+		ret = deflate( zs, flush );
+
+		if (ret == Z_STREAM_ERROR ||
+		    encoder_output( enc, enc->chunk, ENCODE_CHUNK - zs->avail_out ) != 0)
+		{
+			enc->failed = TRUE;
+			return;
+		}
+	} while (zs->avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+#ifdef HAVE_ZSTD
+static void zstd_chunk( struct encoder * enc, const char * data, size_t len, int end ) {
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer out;
+	size_t left;
+
+	in.src = data;
+	in.size = len;
+	in.pos = 0;
+
+	do {
+		out.dst = enc->chunk;
+		out.size = ENCODE_CHUNK;
+		out.pos = 0;
+
+		left = end ? ZSTD_endStream( enc->state, &out ) : ZSTD_compressStream( enc->state, &out, &in );
+
+		if (ZSTD_isError( left ) || encoder_output( enc, enc->chunk, out.pos ) != 0) {
+			enc->failed = TRUE;
+			return;
+		}
+	} while (end ? left != 0 : in.pos < in.size);
+}
+#endif
+
+/* Write 'len' bytes through the encoder. Once something failed the rest is
+   dropped, and encoder_close() says so.
+*/
+void encoder_write( struct encoder * enc, const char * data, size_t len ) {
+	size_t n;
+
+	while (len > 0 && !enc->failed) {
+		n = (len > (1u << 30)) ? (1u << 30) : len;
+
+		if (enc->type == COMPRESS_NONE)
+			enc->failed = (encoder_output( enc, data, n ) != 0);
+		else if (enc->type == COMPRESS_GZIP)
+			deflate_chunk( enc, data, n, Z_NO_FLUSH );
+#ifdef HAVE_ZSTD
+		else
+			zstd_chunk( enc, data, n, FALSE );
+#endif
+
+		data += n;
+		len -= n;
+	}
+}
+
+/* Finish the compressed stream and free the encoder, not closing its file.
+   Returns -1 if anything couldn't be written.
+*/
+int encoder_close( struct encoder * enc ) {
+	if (enc->type == COMPRESS_GZIP) {
+		if (!enc->failed)
+			deflate_chunk( enc, NULL, 0, Z_FINISH );
+
+		deflateEnd( enc->state );
+		free( enc->state );
+	}
+#ifdef HAVE_ZSTD
+	else if (enc->type == COMPRESS_ZSTD) {
+		if (!enc->failed)
+			zstd_chunk( enc, NULL, 0, TRUE );
+
+		ZSTD_freeCStream( enc->state );
+	}
+#endif
+
+	free( enc->chunk );
+	enc->state = NULL;
+	enc->chunk = NULL;
+
+	return enc->failed ? -1 : 0;
+}
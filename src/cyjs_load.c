@@ -0,0 +1,893 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#include "post_run_py.h"
+
+/* cyjs_load.c
+
+   Loads the nodes and edges of a Cytoscape .cyjs network file. The file is
+   mapped and fed through json_scan(), and the records are filled in from the
+   token events, so the layout of the file (pretty printed or compact) doesn't
+   matter. Only the "elements" section is read; the header of the subset file
+   is written out as a constant, without needing to have read it. A gzip or
+   zstd compressed file is decompressed into memory first, see compress.c.
+
+   Big files can be parsed on several threads. A first pass finds the node
+   and edge lists, skipping over their contents, and each list is cut into
+   pieces where a new element seems to start ("}, {"). Each piece is parsed on
+   its own thread into a network of its own, and the pieces are appended to
+   the real network in file order.
+
+   A cut could land inside a string that happens to look like that, but then
+   the piece before it can't end cleanly at the top level of the list. So if
+   every piece parses, starting from the first which is known to be right,
+   every cut was a real element boundary and the result is the same as that
+   of parsing serially. If any piece fails the file is just parsed serially,
+   which also gives the proper error for a file that is really broken.
+
+   A run that only needs some of the nodes can have just those loaded, by
+   name. A first pass then reads no more of each element than its id, and
+   the name of a node or the two ends of an edge, and notes where the wanted
+   nodes and the edges between them are in the file. Only those elements are
+   parsed in full, in a second pass over just their part of the file.
+*/
+
+/* What the container currently being read is, as far as the loader cares. */
+#define  IN_OTHER                 (0)
+#define  IN_ROOT                  (1)
+#define  IN_ELEMENTS              (2)
+#define  IN_NODE_LIST             (3)
+#define  IN_EDGE_LIST             (4)
+#define  IN_NODE                  (5)
+#define  IN_EDGE                  (6)
+#define  IN_NODE_DATA             (7)
+#define  IN_NODE_POSITION         (8)
+#define  IN_EDGE_DATA             (9)
+
+/* Reasons the loader stops the scan, returned through json_scan(). */
+#define  LOAD_BAD_BOOL            (1)
+#define  LOAD_BAD_NUMBER          (2)
+#define  LOAD_NO_ID               (3)
+#define  LOAD_NO_MEMORY           (4)
+/* not an error; the file is parsed serially instead */
+#define  LOAD_SERIAL              (5)
+/* not an error; all of the file is loaded instead of the nodes wanted */
+#define  LOAD_FULL                (6)
+
+/* Files smaller than this aren't worth starting threads for. */
+#define  PARALLEL_MIN_SIZE        (8 << 20)
+#define  MAX_ELEMENT_LISTS        (16)
+#define  MAX_LOAD_THREADS         (64)
+
+/* A node or edge list found by the first pass of a parallel parse. */
+struct element_list {
+	int    role;
+	size_t start;
+	size_t end;
+};
+
+struct cyjs_loader {
+	struct network * net;
+	const char * base;
+	int    depth;
+	int    role[JSON_MAX_DEPTH];
+	const char * key;
+	size_t key_len;
+	int    has_id;
+	int    cur_node;
+	int    cur_edge;
+	/* first pass of a parallel parse: the lists are noted, not read */
+	int    locate;
+	int    num_lists;
+	struct element_list lists[MAX_ELEMENT_LISTS];
+	/* first pass of a load of the wanted nodes: the elements to load are
+	   noted, in runs of neighbours, with the ids of the nodes among them */
+	const struct name_set * wanted;
+	size_t elem_start;
+	int    elem_id;
+	int    elem_source;
+	int    elem_target;
+	int    elem_wanted;
+	int    prev_kept;
+	int    seen_edges;
+	int    num_ids;
+	int    ids_cap;
+	int  * wanted_ids;
+	int    num_kept;
+	int    kept_cap;
+	struct element_list * kept;
+};
+
+/* One piece of a list, parsed on a thread of its own. */
+struct load_piece {
+	struct network part;
+	const char * base;
+	int    role;
+	size_t start;
+	size_t end;
+	size_t stop_off;
+	int    ret;
+};
+
+struct load_pool {
+	struct load_piece * pieces;
+	int    num_pieces;
+	int    next;
+};
+
+/* Map a whole file read-only. An empty file gives an empty mapping.
+*/
+int map_file( const char * file_name, struct mapped_file * file ) {
+	struct stat st;
+	int    fd;
+
+	file->data = NULL;
+	file->size = 0;
+	file->allocated = FALSE;
+
+	fd = open( file_name, O_RDONLY );
+
+	if (fd < 0)
+		return -1;
+
+	if (fstat( fd, &st ) != 0) {
+		close( fd );
+		return -1;
+	}
+
+	if (st.st_size > 0) {
+		file->data = (char *) mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+		if (file->data == MAP_FAILED) {
+			file->data = NULL;
+			close( fd );
+			return -1;
+		}
+
+		file->size = st.st_size;
+		madvise( file->data, file->size, MADV_SEQUENTIAL );
+	}
+
+	close( fd );
+	return 0;
+}
+
+void unmap_file( struct mapped_file * file ) {
+	if (file->allocated)
+		free( file->data );
+	else if (file->data != NULL)
+		munmap( file->data, file->size );
+
+	file->data = NULL;
+	file->size = 0;
+	file->allocated = FALSE;
+}
+
+static int key_is( struct cyjs_loader * ld, const char * key ) {
+	size_t len = strlen( key );
+
+	return ld->key_len == len && memcmp( ld->key, key, len ) == 0;
+}
+
+/* Point 'view' at a string token, keeping at most 'max_len' characters of it
+   but never cutting an escape sequence or a UTF-8 character in half, nor a
+   \uXXXX escape of a high surrogate from the low one after it.
+*/
+static void set_view( struct cyjs_loader * ld, const char * text, size_t len, size_t max_len, struct str_view * view ) {
+	size_t keep;
+	size_t n;
+
+	if (len > max_len) {
+		/* the characters are walked from the start, as only there is it
+		   known which backslashes start an escape; the string goes on past
+		   the cut, so the character after a backslash before it is there */
+		for (keep = 0; keep < max_len; keep += n) {
+			if ((unsigned char) text[keep] >= 0xf0)
+				n = 4;
+			else if ((unsigned char) text[keep] >= 0xe0)
+				n = 3;
+			else if ((unsigned char) text[keep] >= 0xc0)
+				n = 2;
+			else if (text[keep] != '\\')
+				n = 1;
+			else if (text[keep + 1] != 'u')
+				n = 2;
+			else if (keep + 6 <= max_len && (text[keep + 2] == 'd' || text[keep + 2] == 'D') &&
+			         ((text[keep + 3] >= '8' && text[keep + 3] <= '9') ||
+			          (text[keep + 3] >= 'a' && text[keep + 3] <= 'b') ||
+			          (text[keep + 3] >= 'A' && text[keep + 3] <= 'B')))
+				n = 12;
+			else
+				n = 6;
+
+			if (keep + n > max_len)
+				break;
+		}
+	}
+	else
+		keep = len;
+
+	view->off = text - ld->base;
+	view->len = keep;
+}
+
+/* Like set_view(), for the attributes that are interned.
+*/
+static int set_symbol( struct cyjs_loader * ld, const char * text, size_t len, size_t max_len, int * sym ) {
+	struct str_view view;
+
+	set_view( ld, text, len, max_len, &view );
+	*sym = intern_string( ld->net, view.off, view.len );
+
+	return *sym >= 0;
+}
+
+/* Integers may be written as numbers or, like the ids, as strings of digits.
+*/
+static int set_int( int type, const char * text, size_t len, int * val ) {
+	size_t i;
+	int    neg;
+	long   v;
+
+	if (type != JSON_NUMBER && type != JSON_STRING)
+		return 0;
+
+	i = 0;
+	neg = (len > 0 && text[0] == '-');
+
+	if (neg)
+		i++;
+
+	if (i >= len || text[i] < '0' || text[i] > '9')
+		return 0;
+
+	for (v = 0; i < len && text[i] >= '0' && text[i] <= '9'; i++)
+		v = v * 10 + (text[i] - '0');
+
+	*val = (int) (neg ? -v : v);
+	return 1;
+}
+
+/* Numbers are short, so they are copied out of the mapping (which has no
+   terminating '\0') before being converted.
+*/
+static int set_double( int type, const char * text, size_t len, double * val ) {
+	char   num[64];
+	char * num_end;
+
+	if ((type != JSON_NUMBER && type != JSON_STRING) || len == 0 || len > 63)
+		return 0;
+
+	memcpy( num, text, len );
+	num[len] = '\0';
+
+	*val = strtod( num, &num_end );
+
+	return num_end != num;
+}
+
+static int set_bool( int type, unsigned int * bits, int i ) {
+	if (type != JSON_TRUE && type != JSON_FALSE)
+		return 0;
+
+	bit_assign( bits, i, type == JSON_TRUE );
+	return 1;
+}
+
+/* Fill in a field of the current node's "data" or "position" object.
+*/
+static int node_field( struct cyjs_loader * ld, int role, int type, const char * text, size_t len ) {
+	struct network * net = ld->net;
+	int    i = ld->cur_node;
+
+	if (role == IN_NODE_POSITION) {
+		if (key_is( ld, "x" ))
+			return set_double( type, text, len, &net->node_x[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+		if (key_is( ld, "y" ))
+			return set_double( type, text, len, &net->node_y[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+		return 0;
+	}
+
+	if (key_is( ld, "id" )) {
+		ld->has_id = TRUE;
+		return set_int( type, text, len, &net->node_id[i] ) ? 0 : LOAD_BAD_NUMBER;
+	}
+
+	/* names are kept whole, however long, as paths are matched against them */
+	if (key_is( ld, "name" )) {
+		if (type == JSON_STRING)
+			set_view( ld, text, len, len, &net->node_name[i] );
+	}
+	else if (key_is( ld, "shared_name" )) {
+		if (type == JSON_STRING)
+			set_view( ld, text, len, len, &net->node_shared_name[i] );
+	}
+	else if (key_is( ld, "Layer" )) {
+		if (type == JSON_STRING && !set_symbol( ld, text, len, MAX_NODE_STR_LEN, &net->node_Layer[i] ))
+			return LOAD_NO_MEMORY;
+	}
+	else if (key_is( ld, "isExcludedFromPaths" ))
+		return set_bool( type, net->node_isExcludedFromPaths, i ) ? 0 : LOAD_BAD_BOOL;
+	else if (key_is( ld, "isInPath" ))
+		return set_bool( type, net->node_isInPath, i ) ? 0 : LOAD_BAD_BOOL;
+	else if (key_is( ld, "selected" ))
+		return set_bool( type, net->node_selected, i ) ? 0 : LOAD_BAD_BOOL;
+	else if (key_is( ld, "FoldChange" ))
+		return set_double( type, text, len, &net->node_FoldChange[i] ) ? 0 : LOAD_BAD_NUMBER;
+	else if (key_is( ld, "SUID" ))
+		return set_int( type, text, len, &net->node_SUID[i] ) ? 0 : LOAD_BAD_NUMBER;
+	else if (key_is( ld, "Prize" ))
+		return set_int( type, text, len, &net->node_Prize[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+	return 0;
+}
+
+/* Fill in a field of the current edge's "data" object.
+*/
+static int edge_field( struct cyjs_loader * ld, int type, const char * text, size_t len ) {
+	struct network * net = ld->net;
+	int    i = ld->cur_edge;
+
+	if (key_is( ld, "id" )) {
+		ld->has_id = TRUE;
+		return set_int( type, text, len, &net->edge_id[i] ) ? 0 : LOAD_BAD_NUMBER;
+	}
+
+	if (key_is( ld, "source" ))
+		return set_int( type, text, len, &net->edge_source[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+	if (key_is( ld, "target" ))
+		return set_int( type, text, len, &net->edge_target[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+	if (key_is( ld, "interaction" )) {
+		if (type == JSON_STRING && !set_symbol( ld, text, len, MAX_EDGE_STR_LEN, &net->edge_interaction[i] ))
+			return LOAD_NO_MEMORY;
+	}
+	else if (key_is( ld, "Time" )) {
+		if (type == JSON_STRING && !set_symbol( ld, text, len, MAX_EDGE_STR_LEN, &net->edge_Time[i] ))
+			return LOAD_NO_MEMORY;
+	}
+	else if (key_is( ld, "name" )) {
+		if (type == JSON_STRING)
+			set_view( ld, text, len, MAX_EDGE_STR_LEN, &net->edge_name[i] );
+	}
+	else if (key_is( ld, "shared_name" )) {
+		if (type == JSON_STRING)
+			set_view( ld, text, len, MAX_EDGE_STR_LEN, &net->edge_shared_name[i] );
+	}
+	else if (key_is( ld, "sh_interaction" )) {
+		if (type == JSON_STRING && !set_symbol( ld, text, len, MAX_EDGE_STR_LEN, &net->edge_sh_interaction[i] ))
+			return LOAD_NO_MEMORY;
+	}
+	else if (key_is( ld, "isInPath" ))
+		return set_bool( type, net->edge_isInPath, i ) ? 0 : LOAD_BAD_BOOL;
+	else if (key_is( ld, "selected" ))
+		return set_bool( type, net->edge_selected, i ) ? 0 : LOAD_BAD_BOOL;
+	else if (key_is( ld, "SUID" ))
+		return set_int( type, text, len, &net->edge_SUID[i] ) ? 0 : LOAD_BAD_NUMBER;
+
+	return 0;
+}
+
+/* Note the id, and the name or the ends, of an element in the first pass of
+   a load of the wanted nodes.
+*/
+static int prescan_field( struct cyjs_loader * ld, int role, int type, const char * text, size_t len ) {
+	if (role == IN_NODE_DATA) {
+		if (key_is( ld, "id" )) {
+			ld->has_id = TRUE;
+			return set_int( type, text, len, &ld->elem_id ) ? 0 : LOAD_BAD_NUMBER;
+		}
+
+		if (key_is( ld, "name" ) && type == JSON_STRING)
+			ld->elem_wanted = has_name( ld->wanted, text, len );
+	}
+	else if (role == IN_EDGE_DATA) {
+		if (key_is( ld, "id" )) {
+			ld->has_id = TRUE;
+			return set_int( type, text, len, &ld->elem_id ) ? 0 : LOAD_BAD_NUMBER;
+		}
+
+		if (key_is( ld, "source" ))
+			return set_int( type, text, len, &ld->elem_source ) ? 0 : LOAD_BAD_NUMBER;
+
+		if (key_is( ld, "target" ))
+			return set_int( type, text, len, &ld->elem_target ) ? 0 : LOAD_BAD_NUMBER;
+	}
+
+	return 0;
+}
+
+static int compare_ids( const void * a, const void * b ) {
+	int x = *(const int *) a;
+	int y = *(const int *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int is_wanted_id( struct cyjs_loader * ld, int id ) {
+	return ld->num_ids > 0 && bsearch( &id, ld->wanted_ids, ld->num_ids, sizeof( int ), compare_ids ) != NULL;
+}
+
+/* At the end of an element in the first pass of a load of the wanted nodes,
+   keep it if it is a wanted node or an edge between two of them. An element
+   kept right after another is added to the same run of the list.
+*/
+static int keep_element( struct cyjs_loader * ld, int role, const char * text ) {
+	struct element_list * kept;
+	void * grown;
+	int    cap;
+
+	if (role == IN_NODE && ld->elem_wanted) {
+		if (ld->num_ids >= ld->ids_cap) {
+			cap = (ld->ids_cap > 0) ? 2 * ld->ids_cap : 1024;
+
+			if ((grown = realloc( ld->wanted_ids, cap * sizeof( int ) )) == NULL)
+				return LOAD_NO_MEMORY;
+
+			ld->wanted_ids = grown;
+			ld->ids_cap = cap;
+		}
+
+		ld->wanted_ids[ld->num_ids++] = ld->elem_id;
+	}
+	else if (role == IN_NODE || !is_wanted_id( ld, ld->elem_source ) || !is_wanted_id( ld, ld->elem_target )) {
+		ld->prev_kept = FALSE;
+		return 0;
+	}
+
+	if (ld->prev_kept) {
+		ld->kept[ld->num_kept - 1].end = text + 1 - ld->base;
+		return 0;
+	}
+
+	if (ld->num_kept >= ld->kept_cap) {
+		cap = (ld->kept_cap > 0) ? 2 * ld->kept_cap : 256;
+
+		if ((grown = realloc( ld->kept, cap * sizeof( struct element_list ) )) == NULL)
+			return LOAD_NO_MEMORY;
+
+		ld->kept = grown;
+		ld->kept_cap = cap;
+	}
+
+	kept = &ld->kept[ld->num_kept++];
+	kept->role = (role == IN_NODE) ? IN_NODE_LIST : IN_EDGE_LIST;
+	kept->start = ld->elem_start;
+	kept->end = text + 1 - ld->base;
+	ld->prev_kept = TRUE;
+
+	return 0;
+}
+
+/* What the first pass of a load of the wanted nodes does with a container,
+   once open_container() has worked out what it is.
+*/
+static int prescan_container( struct cyjs_loader * ld, int role ) {
+	/* the edges are matched against the ids of the nodes before them */
+	if (role == IN_NODE_LIST && ld->seen_edges)
+		return LOAD_FULL;
+
+	if (role == IN_EDGE_LIST) {
+		if (ld->num_ids > 1)
+			qsort( ld->wanted_ids, ld->num_ids, sizeof( int ), compare_ids );
+
+		ld->seen_edges = TRUE;
+	}
+
+	if (role == IN_NODE_LIST || role == IN_EDGE_LIST)
+		ld->prev_kept = FALSE;
+
+	/* nothing in these is needed to pick the elements */
+	if (role == IN_OTHER || role == IN_NODE_POSITION)
+		return JSON_SKIP;
+
+	return 0;
+}
+
+/* Work out what a new object or array is from what contains it and the key
+   it was found under, starting a new record for each element of the node and
+   edge lists.
+*/
+static int open_container( struct cyjs_loader * ld, int type, const char * text ) {
+	int parent;
+	int role;
+
+	parent = (ld->depth > 0) ? ld->role[ld->depth - 1] : IN_OTHER;
+	role = IN_OTHER;
+
+	if (ld->depth == 0)
+		role = (type == JSON_OBJECT_START) ? IN_ROOT : IN_OTHER;
+	else if (type == JSON_OBJECT_START) {
+		if (parent == IN_ROOT && key_is( ld, "elements" ))
+			role = IN_ELEMENTS;
+		else if (parent == IN_NODE_LIST) {
+			if (ld->wanted != NULL) {
+				ld->elem_start = text - ld->base;
+				ld->elem_wanted = FALSE;
+			}
+			else if ((ld->cur_node = add_node( ld->net )) < 0)
+				return LOAD_NO_MEMORY;
+
+			ld->has_id = FALSE;
+			role = IN_NODE;
+		}
+		else if (parent == IN_EDGE_LIST) {
+			if (ld->wanted != NULL) {
+				ld->elem_start = text - ld->base;
+				ld->elem_source = -1;
+				ld->elem_target = -1;
+			}
+			else if ((ld->cur_edge = add_edge( ld->net )) < 0)
+				return LOAD_NO_MEMORY;
+
+			ld->has_id = FALSE;
+			role = IN_EDGE;
+		}
+		else if (parent == IN_NODE && key_is( ld, "data" ))
+			role = IN_NODE_DATA;
+		else if (parent == IN_NODE && key_is( ld, "position" ))
+			role = IN_NODE_POSITION;
+		else if (parent == IN_EDGE && key_is( ld, "data" ))
+			role = IN_EDGE_DATA;
+	}
+	else if (parent == IN_ELEMENTS && key_is( ld, "nodes" ))
+		role = IN_NODE_LIST;
+	else if (parent == IN_ELEMENTS && key_is( ld, "edges" ))
+		role = IN_EDGE_LIST;
+
+	ld->role[ld->depth++] = role;
+
+	if (ld->locate && (role == IN_NODE_LIST || role == IN_EDGE_LIST)) {
+		if (ld->num_lists == MAX_ELEMENT_LISTS)
+			return LOAD_SERIAL;
+
+		ld->lists[ld->num_lists].role = role;
+		ld->lists[ld->num_lists].start = text - ld->base;
+		return JSON_SKIP;
+	}
+
+	if (ld->wanted != NULL)
+		return prescan_container( ld, role );
+
+	return 0;
+}
+
+static int cyjs_event( void * user, int type, const char * text, size_t len ) {
+	struct cyjs_loader * ld = user;
+	int    role;
+
+	switch (type) {
+	case JSON_OBJECT_START:
+	case JSON_ARRAY_START:
+		return open_container( ld, type, text );
+
+	case JSON_OBJECT_END:
+	case JSON_ARRAY_END:
+		role = ld->role[--ld->depth];
+
+		if (ld->locate && (role == IN_NODE_LIST || role == IN_EDGE_LIST))
+			ld->lists[ld->num_lists++].end = text - ld->base;
+
+		if ((role == IN_NODE || role == IN_EDGE) && ld->has_id == FALSE)
+			return LOAD_NO_ID;
+
+		if (ld->wanted != NULL && (role == IN_NODE || role == IN_EDGE))
+			return keep_element( ld, role, text );
+
+		return 0;
+
+	case JSON_KEY:
+		ld->key = text;
+		ld->key_len = len;
+		return 0;
+
+	default:
+		role = ld->role[ld->depth - 1];
+
+		if (ld->wanted != NULL)
+			return prescan_field( ld, role, type, text, len );
+
+		if (role == IN_NODE_DATA || role == IN_NODE_POSITION)
+			return node_field( ld, role, type, text, len );
+
+		if (role == IN_EDGE_DATA)
+			return edge_field( ld, type, text, len );
+
+		/* "selected" is repeated outside of the data */
+		if (role == IN_NODE && key_is( ld, "selected" ))
+			return set_bool( type, ld->net->node_selected, ld->cur_node ) ? 0 : LOAD_BAD_BOOL;
+
+		if (role == IN_EDGE && key_is( ld, "selected" ))
+			return set_bool( type, ld->net->edge_selected, ld->cur_edge ) ? 0 : LOAD_BAD_BOOL;
+
+		return 0;
+	}
+}
+
+static void * load_pieces( void * arg ) {
+	struct load_pool * pool = arg;
+	struct load_piece * piece;
+	struct cyjs_loader ld;
+	int    i;
+
+	while ((i = __sync_fetch_and_add( &pool->next, 1 )) < pool->num_pieces) {
+		piece = &pool->pieces[i];
+
+		memset( &ld, 0, sizeof( ld ) );
+		ld.net = &piece->part;
+		ld.base = piece->base;
+		ld.role[0] = piece->role;
+		ld.depth = 1;
+
+		piece->ret = json_scan_list( piece->base + piece->start, piece->end - piece->start,
+		                             cyjs_event, &ld, &piece->stop_off );
+		piece->stop_off += piece->start;
+	}
+
+	return NULL;
+}
+
+/* The first place at or after 'off' where a new element of a list seems to
+   start: the '{' of "}, {" with any whitespace around the comma. Returns
+   'end' if there is none before it.
+*/
+static size_t element_start( const char * data, size_t off, size_t end ) {
+	const char * p;
+	const char * q;
+
+	for (p = data + off; p < data + end && (p = memchr( p, ',', data + end - p )) != NULL; p++) {
+		for (q = p - 1; q > data && isspace( (unsigned char) *q ); q--)
+			;
+
+		if (*q != '}')
+			continue;
+
+		for (q = p + 1; q < data + end && isspace( (unsigned char) *q ); q++)
+			;
+
+		if (q < data + end && *q == '{')
+			return q - data;
+	}
+
+	return end;
+}
+
+/* Parse the mapped network file with up to 'num_threads' threads. Returns 0
+   or a reason to stop like json_scan(), or LOAD_SERIAL with 'net' untouched
+   if the file has to be parsed serially instead.
+*/
+static int load_parallel( struct network * net, int num_threads, size_t * stop_off ) {
+	struct cyjs_loader ld;
+	struct load_pool pool;
+	struct load_piece * piece;
+	pthread_t threads[MAX_LOAD_THREADS];
+	int    started[MAX_LOAD_THREADS];
+	size_t start;
+	size_t cut;
+	size_t len;
+	int    l;
+	int    k;
+	int    t;
+	int    ret;
+
+	if (num_threads > MAX_LOAD_THREADS)
+		num_threads = MAX_LOAD_THREADS;
+
+	/* find the lists, without reading them */
+	memset( &ld, 0, sizeof( ld ) );
+	ld.net = net;
+	ld.base = net->file.data;
+	ld.locate = TRUE;
+
+	ret = json_scan( net->file.data, net->file.size, cyjs_event, &ld, stop_off );
+
+	if (ret != 0 || ld.num_lists == 0)
+		return LOAD_SERIAL;
+
+	pool.pieces = (struct load_piece *) calloc( ld.num_lists * num_threads, sizeof( struct load_piece ) );
+	pool.num_pieces = 0;
+	pool.next = 0;
+
+	if (pool.pieces == NULL)
+		return LOAD_SERIAL;
+
+	/* cut each list into about equal pieces; a piece may end after a comma,
+	   so a comma before the end of the list is left to the serial parse */
+	for (l = 0; l < ld.num_lists; l++) {
+		for (cut = ld.lists[l].end - 1; cut > ld.lists[l].start && isspace( (unsigned char) net->file.data[cut] ); cut--)
+			;
+
+		if (net->file.data[cut] == ',') {
+			free( pool.pieces );
+			return LOAD_SERIAL;
+		}
+
+		len = ld.lists[l].end - ld.lists[l].start;
+		start = ld.lists[l].start + 1;
+
+		for (k = 0; k < num_threads; k++) {
+			if (k == num_threads - 1)
+				cut = ld.lists[l].end;
+			else {
+				cut = ld.lists[l].start + len * (k + 1) / num_threads;
+				cut = element_start( net->file.data, (cut > start) ? cut : start, ld.lists[l].end );
+			}
+
+			piece = &pool.pieces[pool.num_pieces++];
+			init_network( &piece->part );
+			piece->part.text = net->text;
+			piece->base = net->file.data;
+			piece->role = ld.lists[l].role;
+			piece->start = start;
+			piece->end = cut;
+
+			start = cut;
+		}
+	}
+
+	/* a thread that can't be started leaves its share to the others */
+	for (t = 1; t < num_threads; t++)
+		started[t] = (pthread_create( &threads[t], NULL, load_pieces, &pool ) == 0);
+
+	load_pieces( &pool );
+
+	for (t = 1; t < num_threads; t++) {
+		if (started[t])
+			pthread_join( threads[t], NULL );
+	}
+
+	ret = 0;
+
+	for (k = 0; k < pool.num_pieces && ret == 0; k++) {
+		if (pool.pieces[k].ret != 0)
+			ret = LOAD_SERIAL;
+	}
+
+	/* put the pieces together in file order */
+	for (k = 0; k < pool.num_pieces; k++) {
+		piece = &pool.pieces[k];
+
+		if (ret == 0 && append_network( net, &piece->part ) != 0) {
+			*stop_off = piece->start;
+			ret = LOAD_NO_MEMORY;
+		}
+
+		free_network( &piece->part );
+	}
+
+	free( pool.pieces );
+	return ret;
+}
+
+/* Load the nodes of the mapped network file whose names are 'wanted', and the
+   edges between them. Returns 0 or a reason to stop like json_scan(), or
+   LOAD_FULL with 'net' untouched if all of the file has to be loaded instead.
+*/
+static int load_wanted( struct network * net, const struct name_set * wanted, size_t * stop_off ) {
+	struct cyjs_loader pre;
+	struct cyjs_loader ld;
+	struct element_list * kept;
+	int    ret;
+	int    k;
+
+	memset( &pre, 0, sizeof( pre ) );
+	pre.net = net;
+	pre.base = net->file.data;
+	pre.wanted = wanted;
+
+	ret = json_scan( net->file.data, net->file.size, cyjs_event, &pre, stop_off );
+
+	/* each run of kept elements is parsed as a piece of its list */
+	for (k = 0; k < pre.num_kept && ret == 0; k++) {
+		kept = &pre.kept[k];
+
+		memset( &ld, 0, sizeof( ld ) );
+		ld.net = net;
+		ld.base = net->file.data;
+		ld.role[0] = kept->role;
+		ld.depth = 1;
+
+		ret = json_scan_list( net->file.data + kept->start, kept->end - kept->start, cyjs_event, &ld, stop_off );
+		*stop_off += kept->start;
+	}
+
+	free( pre.wanted_ids );
+	free( pre.kept );
+
+	return ret;
+}
+
+/* Load the nodes and edges of the network file into the columns of 'net', in
+   file order, with up to 'num_threads' threads if the file is big enough.
+   With 'wanted' only the nodes of those names, and the edges between them,
+   are loaded. The caller frees the network with free_network() when done
+   with it, also after a failed load, whose reason is added to 'report'.
+*/
+int load_network( const char * file_name, struct network * net, const struct name_set * wanted, int num_threads,
+                  struct report * report )
+{
+	struct cyjs_loader ld;
+	size_t stop_off;
+	size_t i;
+	int    line_num;
+	int    ret;
+
+	init_network( net );
+
+	if (map_file( file_name, &net->file ) != 0) {
+		printf( "could not open \"%s\".\n", file_name );
+		write_out_message( report, "Unable to open the network file." );
+		return -1;
+	}
+
+	if (decompress_file( &net->file ) != 0) {
+		printf( "could not decompress \"%s\".\n", file_name );
+		write_out_message( report, "Unable to read the network file (bad compressed data)." );
+		return -1;
+	}
+
+	net->text = net->file.data;
+	ret = LOAD_FULL;
+
+	if (wanted != NULL && (ret = load_wanted( net, wanted, &stop_off )) == LOAD_FULL)
+		printf( "post_run_py: the edges of \"%s\" come before its nodes; loading all of it\n", file_name );
+
+	if (ret == LOAD_FULL) {
+		ret = LOAD_SERIAL;
+
+		if (num_threads > 1 && net->file.size >= PARALLEL_MIN_SIZE)
+			ret = load_parallel( net, num_threads, &stop_off );
+	}
+
+	if (ret == LOAD_SERIAL) {
+		memset( &ld, 0, sizeof( ld ) );
+		ld.net = net;
+		ld.base = net->file.data;
+
+		ret = json_scan( net->file.data, net->file.size, cyjs_event, &ld, &stop_off );
+	}
+
+	if (ret == 0)
+		return 0;
+
+	/* only count lines when there is something to complain about */
+	for (i = 0, line_num = 1; i < stop_off; i++)
+		if (net->file.data[i] == '\n')
+			line_num++;
+
+	switch (ret) {
+	case LOAD_BAD_BOOL:
+		printf( "value is neither true nor false: line %d\n", line_num );
+		break;
+
+	case LOAD_BAD_NUMBER:
+		printf( "failed to read a number on line %d\n", line_num );
+		break;
+
+	case LOAD_NO_ID:
+		printf( "node or edge without an id, line %d\n", line_num );
+		break;
+
+	case LOAD_NO_MEMORY:
+		printf( "out of memory on line %d\n", line_num );
+		write_out_message( report, "Unable to read the network file (out of memory)." );
+		return -1;
+
+	default:
+		printf( "JSON syntax error on line %d\n", line_num );
+		break;
+	}
+
+	write_out_message( report, "Unable to read the network file (bad format)." );
+	return -1;
+}
@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "post_run_py.h"
+
+/* cyjs_write.c
+
+   Writes the subset network of a run as a Cytoscape .cyjs file. Records are
+   formatted straight into a large buffer, which goes out in big writes when
+   it fills up, instead of through a handful of fprintf() calls per field.
+   A file named *.gz or *.zst is compressed on the way, see compress.c.
+
+   The pretty printed layout is the one the program always wrote, byte for
+   byte, with the numbers as "%lf" would give them. The compact layout leaves
+   out all the whitespace and gives each number in the fewest digits that
+   read back as the same double.
+*/
+
+#define  OUT_BUFFER_SIZE          (1 << 20)
+
+struct out_buffer {
+	char * buf;
+	size_t len;
+	struct encoder enc;
+};
+
+static void out_flush( struct out_buffer * out ) {
+	encoder_write( &out->enc, out->buf, out->len );
+	out->len = 0;
+}
+
+/* Make room for 'size' more bytes, which must be well under the buffer size.
+*/
+static inline char * out_reserve( struct out_buffer * out, size_t size ) {
+	if (out->len + size > OUT_BUFFER_SIZE)
+		out_flush( out );
+
+	return out->buf + out->len;
+}
+
+static void out_mem( struct out_buffer * out, const char * s, size_t len ) {
+	size_t n;
+
+	while (len > 0) {
+		if (out->len == OUT_BUFFER_SIZE)
+			out_flush( out );
+
+		n = OUT_BUFFER_SIZE - out->len;
+
+		if (n > len)
+			n = len;
+
+		memcpy( out->buf + out->len, s, n );
+		out->len += n;
+		s += n;
+		len -= n;
+	}
+}
+
+static inline void out_str( struct out_buffer * out, const char * s ) {
+	out_mem( out, s, strlen( s ) );
+}
+
+static inline void out_view( struct out_buffer * out, const char * text, const struct str_view * view ) {
+	out_mem( out, text + view->off, view->len );
+}
+
+/* Digits of 'val' backwards from 'end', returning where they start.
+*/
+static inline char * format_digits( char * end, unsigned long long val ) {
+	do {
+		*--end = '0' + (val % 10);
+		val /= 10;
+	} while (val != 0);
+
+	return end;
+}
+
+static void out_int( struct out_buffer * out, long long val ) {
+	char   digits[24];
+	char * p;
+	char * dst;
+	size_t len;
+
+	p = format_digits( digits + sizeof( digits ), (val < 0) ? -(unsigned long long) val : (unsigned long long) val );
+
+	if (val < 0)
+		*--p = '-';
+
+	len = digits + sizeof( digits ) - p;
+	dst = out_reserve( out, len );
+	memcpy( dst, p, len );
+	out->len += len;
+}
+
+/* 'val' as "%lf" gives it: six decimals, rounded half to even from the exact
+   binary value. A double is m * 2^e, so the scaled value m * 10^6 / 2^-e is
+   worked out exactly in 128 bits and rounded by hand. Values that are too
+   big for that, and infinities and NaNs, are left to snprintf().
+*/
+static void out_fixed6( struct out_buffer * out, double val ) {
+	/* "%lf" of the biggest double has over 300 digits */
+	char   digits[400];
+	char * p;
+	char * dst;
+	unsigned __int128 scaled;
+	unsigned __int128 rest;
+	unsigned __int128 half;
+	unsigned long long whole;
+	unsigned long long mant;
+	int    frac;
+	int    exp;
+	int    shift;
+	int    i;
+	size_t len;
+
+	if (!isfinite( val ) || fabs( val ) >= 9007199254740992.0) {
+		len = snprintf( digits, sizeof( digits ), "%lf", val );
+		out_mem( out, digits, len );
+		return;
+	}
+
+	/* val = mant * 2^(exp - 53) with mant < 2^53 */
+	mant = (unsigned long long) ldexp( frexp( fabs( val ), &exp ), 53 );
+	shift = 53 - exp;
+
+	if (shift <= 0)
+		scaled = (unsigned __int128) (mant << -shift) * 1000000;
+	else if (shift >= 100)
+		scaled = 0;
+	else {
+		scaled = (unsigned __int128) mant * 1000000;
+		rest = scaled & ((((unsigned __int128) 1) << shift) - 1);
+		half = ((unsigned __int128) 1) << (shift - 1);
+		scaled >>= shift;
+
+		if (rest > half || (rest == half && (scaled & 1)))
+			scaled++;
+	}
+
+	whole = (unsigned long long) (scaled / 1000000);
+	frac = (int) (scaled % 1000000);
+
+	p = digits + sizeof( digits );
+
+	for (i = 0; i < 6; i++) {
+		*--p = '0' + frac % 10;
+		frac /= 10;
+	}
+
+	*--p = '.';
+	p = format_digits( p, whole );
+
+	if (signbit( val ))
+		*--p = '-';
+
+	len = digits + sizeof( digits ) - p;
+	dst = out_reserve( out, len );
+	memcpy( dst, p, len );
+	out->len += len;
+}
+
+/* 'val' in the fewest digits that read back as the same double, with at
+   least one decimal so it stays a floating point number. With 'n' digits
+   and 'k' decimals the value read back is the correctly rounded n / 10^k,
+   which for n < 2^53 and k <= 22 is exactly what dividing the two doubles
+   gives, so each candidate is checked without calling strtod(). Anything
+   that needs more digits than that goes through snprintf() instead.
+*/
+static void out_shortest( struct out_buffer * out, double val ) {
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	char   digits[48];
+	char * p;
+	char * dst;
+	double mag;
+	double n;
+	double cand;
+	int    k;
+	int    i;
+	int    d;
+	size_t len;
+
+	mag = fabs( val );
+
+	if (isfinite( val ) && mag < 9007199254740992.0) {
+		for (k = 1; k <= 22 && mag * powers[k] < 9007199254740992.0; k++) {
+			n = nearbyint( mag * powers[k] );
+
+			/* the product may have been rounded to the wrong side */
+			for (d = 0; d < 3; d++) {
+				cand = n + ((d == 1) ? -1 : (d == 2) ? 1 : 0);
+
+				if (cand >= 0 && cand / powers[k] == mag)
+					break;
+			}
+
+			if (d == 3)
+				continue;
+
+			p = format_digits( digits + sizeof( digits ), (unsigned long long) cand );
+
+			/* pad to at least one whole digit, then place the point */
+			while (digits + sizeof( digits ) - p <= k)
+				*--p = '0';
+
+			len = digits + sizeof( digits ) - p;
+			memmove( p - 1, p, len - k );
+			p[len - k - 1] = '.';
+			p--;
+
+			/* "1.50" doesn't happen, as 1.5 would have matched first */
+			if (signbit( val ))
+				*--p = '-';
+
+			len = digits + sizeof( digits ) - p;
+			dst = out_reserve( out, len );
+			memcpy( dst, p, len );
+			out->len += len;
+			return;
+		}
+	}
+
+	for (i = 1; i <= 17; i++) {
+		len = snprintf( digits, sizeof( digits ), "%.*g", i, val );
+
+		if (!isfinite( val ) || strtod( digits, NULL ) == val)
+			break;
+	}
+
+	/* JSON has no infinities or NaNs */
+	if (!isfinite( val ))
+		len = snprintf( digits, sizeof( digits ), "null" );
+	else if (strpbrk( digits, ".e" ) == NULL)
+		len += snprintf( digits + len, sizeof( digits ) - len, ".0" );
+
+	out_mem( out, digits, len );
+}
+
+static inline void out_bool( struct out_buffer * out, const unsigned int * bits, int i ) {
+	if (bit_test( bits, i ))
+		out_mem( out, "true", 4 );
+	else
+		out_mem( out, "false", 5 );
+}
+
+static void out_symbol( struct out_buffer * out, struct network * net, int sym ) {
+	out_mem( out, "\"", 1 );
+	out_view( out, net->text, &net->pool.strings[sym] );
+	out_mem( out, "\"", 1 );
+}
+
+static void out_string( struct out_buffer * out, struct network * net, const struct str_view * view ) {
+	out_mem( out, "\"", 1 );
+	out_view( out, net->text, view );
+	out_mem( out, "\"", 1 );
+}
+
+static void out_quoted_int( struct out_buffer * out, int val ) {
+	out_mem( out, "\"", 1 );
+	out_int( out, val );
+	out_mem( out, "\"", 1 );
+}
+
+static void write_pretty( struct out_buffer * out, struct run * run ) {
+	struct network * net = run->net;
+	int    need_braces_line;
+	int    i;
+
+	out_str( out, "{\n" );
+	out_str( out, "  \"format_version\" : \"1.0\",\n" );
+	out_str( out, "  \"generated_by\" : \"cytoscape-3.7.2\",\n" );
+	out_str( out, "  \"target_cytoscapejs_version\" : \"~2.1\",\n" );
+	out_str( out, "  \"data\" : {\n" );
+	out_str( out, "    \"shared_name\" : \"my_time1_all_edge.txt\",\n" );
+	out_str( out, "    \"name\" : \"my_time1_all_edge.txt\",\n" );
+	out_str( out, "    \"SUID\" : 81000,\n" );
+	out_str( out, "    \"__Annotations\" : [ \"\" ],\n" );
+	out_str( out, "    \"selected\" : true\n" );
+	out_str( out, "  },\n" );
+	out_str( out, "  \"elements\" : {\n" );
+	out_str( out, "    \"nodes\" : [ {\n" );
+
+	need_braces_line = FALSE;
+
+	/* newest first, as the old list based loader kept them */
+	for (i = bit_prev( run->node_output, net->num_nodes - 1 ); i >= 0; i = bit_prev( run->node_output, i - 1 )) {
+		if (need_braces_line == TRUE)
+			out_str( out, "    }, {\n" );
+
+		out_str( out, "      \"data\" : {\n" );
+		out_str( out, "        \"id\" : " );
+		out_quoted_int( out, net->node_id[i] );
+		out_str( out, ",\n        \"shared_name\" : " );
+		out_string( out, net, &net->node_shared_name[i] );
+		out_str( out, ",\n        \"isExcludedFromPaths\" : " );
+		out_bool( out, net->node_isExcludedFromPaths, i );
+		out_str( out, ",\n        \"name\" : " );
+		out_string( out, net, &net->node_name[i] );
+		out_str( out, ",\n        \"isInPath\" : " );
+		out_bool( out, net->node_isInPath, i );
+		out_str( out, ",\n        \"FoldChange\" : " );
+		out_fixed6( out, net->node_FoldChange[i] );
+		out_str( out, ",\n        \"SUID\" : " );
+		out_int( out, net->node_SUID[i] );
+		out_str( out, ",\n        \"Layer\" : " );
+		out_symbol( out, net, net->node_Layer[i] );
+		out_str( out, ",\n        \"Prize\" : " );
+		out_int( out, net->node_Prize[i] );
+		out_str( out, ",\n        \"selected\" : " );
+		out_bool( out, net->node_selected, i );
+		out_str( out, "\n      },\n" );
+		out_str( out, "      \"position\" : {\n" );
+		out_str( out, "        \"x\" : " );
+		out_fixed6( out, net->node_x[i] );
+		out_str( out, ",\n        \"y\" : " );
+		out_fixed6( out, net->node_y[i] );
+		out_str( out, "\n      },\n" );
+		out_str( out, "      \"selected\" : " );
+		out_bool( out, net->node_selected, i );
+		out_str( out, "\n" );
+
+		need_braces_line = TRUE;
+	}
+
+	out_str( out, "    } ],\n" );
+	out_str( out, "    \"edges\" : [ {\n" );
+
+	need_braces_line = FALSE;
+
+	for (i = bit_prev( run->edge_output, net->num_edges - 1 ); i >= 0; i = bit_prev( run->edge_output, i - 1 )) {
+		if (need_braces_line == TRUE)
+			out_str( out, "    }, {\n" );
+
+		out_str( out, "      \"data\" : {\n" );
+		out_str( out, "        \"id\" : " );
+		out_quoted_int( out, net->edge_id[i] );
+		out_str( out, ",\n        \"source\" : " );
+		out_quoted_int( out, net->edge_source[i] );
+		out_str( out, ",\n        \"target\" : " );
+		out_quoted_int( out, net->edge_target[i] );
+		out_str( out, ",\n        \"shared_name\" : " );
+		out_string( out, net, &net->edge_shared_name[i] );
+		out_str( out, ",\n        \"sh_interaction\" : " );
+		out_symbol( out, net, net->edge_sh_interaction[i] );
+		out_str( out, ",\n        \"name\" : " );
+		out_string( out, net, &net->edge_name[i] );
+		out_str( out, ",\n        \"interaction\" : " );
+		out_symbol( out, net, net->edge_interaction[i] );
+		out_str( out, ",\n        \"isInPath\" : " );
+		out_bool( out, net->edge_isInPath, i );
+		out_str( out, ",\n        \"SUID\" : " );
+		out_int( out, net->edge_SUID[i] );
+		out_str( out, ",\n        \"Time\" : " );
+		out_symbol( out, net, net->edge_Time[i] );
+		out_str( out, ",\n        \"selected\" : " );
+		out_bool( out, net->edge_selected, i );
+		out_str( out, "\n      },\n" );
+		out_str( out, "      \"selected\" : " );
+		out_bool( out, net->edge_selected, i );
+		out_str( out, "\n" );
+
+		need_braces_line = TRUE;
+	}
+
+	out_str( out, "    } ]\n" );
+	out_str( out, "  }\n" );
+	out_str( out, "}\n" );
+}
+
+static void write_compact( struct out_buffer * out, struct run * run ) {
+	struct network * net = run->net;
+	int    first;
+	int    i;
+
+	out_str( out, "{\"format_version\":\"1.0\",\"generated_by\":\"cytoscape-3.7.2\","
+	              "\"target_cytoscapejs_version\":\"~2.1\",\"data\":{\"shared_name\":\"my_time1_all_edge.txt\","
+	              "\"name\":\"my_time1_all_edge.txt\",\"SUID\":81000,\"__Annotations\":[\"\"],\"selected\":true},"
+	              "\"elements\":{\"nodes\":[" );
+
+	first = TRUE;
+
+	for (i = bit_prev( run->node_output, net->num_nodes - 1 ); i >= 0; i = bit_prev( run->node_output, i - 1 )) {
+		out_str( out, first ? "{\"data\":{\"id\":" : ",{\"data\":{\"id\":" );
+		out_quoted_int( out, net->node_id[i] );
+		out_str( out, ",\"shared_name\":" );
+		out_string( out, net, &net->node_shared_name[i] );
+		out_str( out, ",\"isExcludedFromPaths\":" );
+		out_bool( out, net->node_isExcludedFromPaths, i );
+		out_str( out, ",\"name\":" );
+		out_string( out, net, &net->node_name[i] );
+		out_str( out, ",\"isInPath\":" );
+		out_bool( out, net->node_isInPath, i );
+		out_str( out, ",\"FoldChange\":" );
+		out_shortest( out, net->node_FoldChange[i] );
+		out_str( out, ",\"SUID\":" );
+		out_int( out, net->node_SUID[i] );
+		out_str( out, ",\"Layer\":" );
+		out_symbol( out, net, net->node_Layer[i] );
+		out_str( out, ",\"Prize\":" );
+		out_int( out, net->node_Prize[i] );
+		out_str( out, ",\"selected\":" );
+		out_bool( out, net->node_selected, i );
+		out_str( out, "},\"position\":{\"x\":" );
+		out_shortest( out, net->node_x[i] );
+		out_str( out, ",\"y\":" );
+		out_shortest( out, net->node_y[i] );
+		out_str( out, "},\"selected\":" );
+		out_bool( out, net->node_selected, i );
+		out_str( out, "}" );
+
+		first = FALSE;
+	}
+
+	out_str( out, "],\"edges\":[" );
+
+	first = TRUE;
+
+	for (i = bit_prev( run->edge_output, net->num_edges - 1 ); i >= 0; i = bit_prev( run->edge_output, i - 1 )) {
+		out_str( out, first ? "{\"data\":{\"id\":" : ",{\"data\":{\"id\":" );
+		out_quoted_int( out, net->edge_id[i] );
+		out_str( out, ",\"source\":" );
+		out_quoted_int( out, net->edge_source[i] );
+		out_str( out, ",\"target\":" );
+		out_quoted_int( out, net->edge_target[i] );
+		out_str( out, ",\"shared_name\":" );
+		out_string( out, net, &net->edge_shared_name[i] );
+		out_str( out, ",\"sh_interaction\":" );
+		out_symbol( out, net, net->edge_sh_interaction[i] );
+		out_str( out, ",\"name\":" );
+		out_string( out, net, &net->edge_name[i] );
+		out_str( out, ",\"interaction\":" );
+		out_symbol( out, net, net->edge_interaction[i] );
+		out_str( out, ",\"isInPath\":" );
+		out_bool( out, net->edge_isInPath, i );
+		out_str( out, ",\"SUID\":" );
+		out_int( out, net->edge_SUID[i] );
+		out_str( out, ",\"Time\":" );
+		out_symbol( out, net, net->edge_Time[i] );
+		out_str( out, ",\"selected\":" );
+		out_bool( out, net->edge_selected, i );
+		out_str( out, "},\"selected\":" );
+		out_bool( out, net->edge_selected, i );
+		out_str( out, "}" );
+
+		first = FALSE;
+	}
+
+	out_str( out, "]}}\n" );
+}
+
+/* Write out the subset of the network for display: every node and edge flagged
+   for output, with the header of the original network files. It only
+   replaces the old file once it has been written completely.
+*/
+int write_subset_network( struct run * run, int compact ) {
+	struct out_buffer out;
+	char   tmp_name[MAX_LINE_LEN + 64];
+	int    fd;
+	int    ok;
+
+	out.buf = (char *) malloc( OUT_BUFFER_SIZE );
+	out.len = 0;
+	fd = -1;
+
+	if (out.buf != NULL)
+		fd = open_output( run->files->out_cyjs, tmp_name, sizeof( tmp_name ) );
+
+	if (fd >= 0 && encoder_open( &out.enc, output_compression( run->files->out_cyjs ), fd ) != 0) {
+		finish_output( fd, run->files->out_cyjs, tmp_name, FALSE );
+		fd = -1;
+	}
+
+	if (fd < 0) {
+		free( out.buf );
+		printf( "could not open '%s'\n", run->files->out_cyjs );
+		write_out_message( &run->report, "Unable to open the sub-network file to write." );
+		return -1;
+	}
+
+	if (compact)
+		write_compact( &out, run );
+	else
+		write_pretty( &out, run );
+
+	out_flush( &out );
+	free( out.buf );
+	ok = (encoder_close( &out.enc ) == 0);
+	run->metrics.bytes_written += out.enc.bytes_written;
+
+	if (finish_output( fd, run->files->out_cyjs, tmp_name, ok ) != 0) {
+		printf( "could not write '%s'\n", run->files->out_cyjs );
+		write_out_message( &run->report, "Unable to write the sub-network file." );
+		return -1;
+	}
+
+	return 0;
+}
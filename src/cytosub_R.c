@@ -0,0 +1,643 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "post_run_py.h"
+
+/* cytosub_R.c
+
+   The entry points called from R. Besides running the whole post-processing
+   in one go, a network can be loaded once and kept as an external pointer, so
+   that paths from any number of runs can be processed against it without
+   reading the .cyjs file again.
+*/
+
+#define CHARPT(x,i)	((char*)CHAR(STRING_ELT(x,i)))
+
+SEXP R_post_run_py(SEXP R_args){
+	int i;
+	int argc=length(R_args);
+	char **argv;
+
+	argv=malloc(sizeof(*argv)*argc);
+	if(argv==NULL)
+		return NULL;
+	for(i=0;i<argc;i++){
+		argv[i]=CHARPT(R_args, i);
+	}
+
+	post_run_py(argc,argv);
+
+	free(argv);
+
+	return NULL;
+}
+
+static void check_strings(SEXP R_x, int n, const char *what){
+	if(!isString(R_x) || length(R_x)!=n)
+		error("%s must be %s", what, n==1 ? "a single string" : "a character vector, one per job");
+}
+
+static int threads_arg(SEXP R_threads){
+	int threads=asInteger(R_threads);
+
+	if(threads==NA_INTEGER || threads<1)
+		error("'threads' must be a positive number");
+
+	return threads;
+}
+
+static void network_finalizer(SEXP R_net){
+	struct network *net=R_ExternalPtrAddr(R_net);
+
+	if(net==NULL)
+		return;
+
+	free_network(net);
+	free(net);
+	R_ClearExternalPtr(R_net);
+}
+
+static struct network *network_handle(SEXP R_net){
+	struct network *net;
+
+	if(TYPEOF(R_net)!=EXTPTRSXP || R_ExternalPtrTag(R_net)!=install("cytosub_network"))
+		error("not a cytosub network");
+
+	net=R_ExternalPtrAddr(R_net);
+	if(net==NULL)
+		error("the cytosub network has been closed");
+
+	return net;
+}
+
+/* Load the network file and return a handle to it. The network is freed when
+   the handle is closed or garbage collected.
+*/
+SEXP R_cytosub_load(SEXP R_file, SEXP R_threads){
+	struct network *net;
+	struct report report;
+	SEXP R_net;
+	int ret, threads;
+
+	if(!isString(R_file) || length(R_file)!=1)
+		error("the network file name must be a single string");
+	threads=threads_arg(R_threads);
+
+	net=malloc(sizeof(*net));
+	if(net==NULL)
+		error("out of memory");
+
+	begin_report(&report);
+	ret=open_network(CHARPT(R_file, 0),net,threads,&report);
+	end_report(&report,ret,NULL);
+
+	if(ret!=0){
+		free(net);
+		error("unable to load the network file '%s': %s", CHARPT(R_file, 0), last_out_message(&report));
+	}
+
+	R_net=PROTECT(R_MakeExternalPtr(net,install("cytosub_network"),R_NilValue));
+	R_RegisterCFinalizerEx(R_net,network_finalizer,TRUE);
+	UNPROTECT(1);
+
+	return R_net;
+}
+
+static SEXP view_string(struct network *net, const struct str_view *view){
+	return mkCharLen(net->text+view->off,(int)view->len);
+}
+
+static SEXP symbol_string(struct network *net, int sym){
+	return view_string(net,&net->pool.strings[sym]);
+}
+
+/* Turn a list of equal length columns into a data frame in place.
+*/
+static SEXP as_data_frame(SEXP R_df, const char **names, int nrow){
+	SEXP R_names, R_rows;
+	int i, ncol=length(R_df);
+
+	R_names=PROTECT(allocVector(STRSXP,ncol));
+	for(i=0;i<ncol;i++)
+		SET_STRING_ELT(R_names,i,mkChar(names[i]));
+	setAttrib(R_df,R_NamesSymbol,R_names);
+
+	/* compact row names, c(NA, -nrow) */
+	R_rows=PROTECT(allocVector(INTSXP,2));
+	INTEGER(R_rows)[0]=NA_INTEGER;
+	INTEGER(R_rows)[1]=-nrow;
+	setAttrib(R_df,R_RowNamesSymbol,R_rows);
+	setAttrib(R_df,R_ClassSymbol,mkString("data.frame"));
+
+	UNPROTECT(2);
+	return R_df;
+}
+
+/* The flagged nodes, in the same order as in the subset network file.
+*/
+static SEXP node_frame(struct run *run){
+	static const char *names[]={"id","shared_name","name","isExcludedFromPaths","isInPath",
+		"FoldChange","SUID","Layer","Prize","selected","x","y"};
+	struct network *net=run->net;
+	SEXP R_df, R_col[12];
+	int i, row, nrow=bit_count(run->node_output,net->num_nodes);
+
+	R_df=PROTECT(allocVector(VECSXP,12));
+	SET_VECTOR_ELT(R_df,0,R_col[0]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,1,R_col[1]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,2,R_col[2]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,3,R_col[3]=allocVector(LGLSXP,nrow));
+	SET_VECTOR_ELT(R_df,4,R_col[4]=allocVector(LGLSXP,nrow));
+	SET_VECTOR_ELT(R_df,5,R_col[5]=allocVector(REALSXP,nrow));
+	SET_VECTOR_ELT(R_df,6,R_col[6]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,7,R_col[7]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,8,R_col[8]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,9,R_col[9]=allocVector(LGLSXP,nrow));
+	SET_VECTOR_ELT(R_df,10,R_col[10]=allocVector(REALSXP,nrow));
+	SET_VECTOR_ELT(R_df,11,R_col[11]=allocVector(REALSXP,nrow));
+
+	for(i=net->num_nodes-1,row=0;i>=0;i--){
+		if(!bit_test(run->node_output,i))
+			continue;
+		INTEGER(R_col[0])[row]=net->node_id[i];
+		SET_STRING_ELT(R_col[1],row,view_string(net,&net->node_shared_name[i]));
+		SET_STRING_ELT(R_col[2],row,view_string(net,&net->node_name[i]));
+		LOGICAL(R_col[3])[row]=bit_test(net->node_isExcludedFromPaths,i);
+		LOGICAL(R_col[4])[row]=bit_test(net->node_isInPath,i);
+		REAL(R_col[5])[row]=net->node_FoldChange[i];
+		INTEGER(R_col[6])[row]=net->node_SUID[i];
+		SET_STRING_ELT(R_col[7],row,symbol_string(net,net->node_Layer[i]));
+		INTEGER(R_col[8])[row]=net->node_Prize[i];
+		LOGICAL(R_col[9])[row]=bit_test(net->node_selected,i);
+		REAL(R_col[10])[row]=net->node_x[i];
+		REAL(R_col[11])[row]=net->node_y[i];
+		row++;
+	}
+
+	as_data_frame(R_df,names,nrow);
+	UNPROTECT(1);
+	return R_df;
+}
+
+/* The flagged edges, in the same order as in the subset network file.
+*/
+static SEXP edge_frame(struct run *run){
+	static const char *names[]={"id","source","target","shared_name","sh_interaction","name",
+		"interaction","isInPath","SUID","Time","selected"};
+	struct network *net=run->net;
+	SEXP R_df, R_col[11];
+	int i, row, nrow=bit_count(run->edge_output,net->num_edges);
+
+	R_df=PROTECT(allocVector(VECSXP,11));
+	SET_VECTOR_ELT(R_df,0,R_col[0]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,1,R_col[1]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,2,R_col[2]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,3,R_col[3]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,4,R_col[4]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,5,R_col[5]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,6,R_col[6]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,7,R_col[7]=allocVector(LGLSXP,nrow));
+	SET_VECTOR_ELT(R_df,8,R_col[8]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,9,R_col[9]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,10,R_col[10]=allocVector(LGLSXP,nrow));
+
+	for(i=net->num_edges-1,row=0;i>=0;i--){
+		if(!bit_test(run->edge_output,i))
+			continue;
+		INTEGER(R_col[0])[row]=net->edge_id[i];
+		INTEGER(R_col[1])[row]=net->edge_source[i];
+		INTEGER(R_col[2])[row]=net->edge_target[i];
+		SET_STRING_ELT(R_col[3],row,view_string(net,&net->edge_shared_name[i]));
+		SET_STRING_ELT(R_col[4],row,symbol_string(net,net->edge_sh_interaction[i]));
+		SET_STRING_ELT(R_col[5],row,view_string(net,&net->edge_name[i]));
+		SET_STRING_ELT(R_col[6],row,symbol_string(net,net->edge_interaction[i]));
+		LOGICAL(R_col[7])[row]=bit_test(net->edge_isInPath,i);
+		INTEGER(R_col[8])[row]=net->edge_SUID[i];
+		SET_STRING_ELT(R_col[9],row,symbol_string(net,net->edge_Time[i]));
+		LOGICAL(R_col[10])[row]=bit_test(net->edge_selected,i);
+		row++;
+	}
+
+	as_data_frame(R_df,names,nrow);
+	UNPROTECT(1);
+	return R_df;
+}
+
+/* One row per hop of every path, in the order of the text report. Paths are
+   numbered from 1 in the order of the paths file, and carry the rank and
+   cost it gave them. Layers of names that aren't in the network, and the
+   edge of the last hop, are NA.
+*/
+static SEXP path_frame(struct run *run){
+	static const char *names[]={"path","rank","cost","hop","name","Layer","interaction","Time"};
+	struct network *net=run->net;
+	struct path_list *paths=&run->paths;
+	SEXP R_df, R_col[8];
+	const char *name;
+	size_t len;
+	long hop;
+	int nrow, row, path, node, edge;
+
+	nrow=(int)paths->num_hops;
+
+	R_df=PROTECT(allocVector(VECSXP,8));
+	SET_VECTOR_ELT(R_df,0,R_col[0]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,1,R_col[1]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,2,R_col[2]=allocVector(REALSXP,nrow));
+	SET_VECTOR_ELT(R_df,3,R_col[3]=allocVector(INTSXP,nrow));
+	SET_VECTOR_ELT(R_df,4,R_col[4]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,5,R_col[5]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,6,R_col[6]=allocVector(STRSXP,nrow));
+	SET_VECTOR_ELT(R_df,7,R_col[7]=allocVector(STRSXP,nrow));
+
+	/* the report has the paths last one first */
+	row=0;
+	for(path=paths->num_paths-1;path>=0;path--){
+		for(hop=paths->path_start[path];hop<paths->path_start[path+1];hop++,row++){
+			node=paths->hop_node[hop];
+			edge=hop_edge(paths,hop);
+			name=hop_name(net,paths,node,&len);
+			INTEGER(R_col[0])[row]=path+1;
+			INTEGER(R_col[1])[row]=paths->rank[path];
+			REAL(R_col[2])[row]=paths->cost[path];
+			INTEGER(R_col[3])[row]=(int)(hop-paths->path_start[path])+1;
+			SET_STRING_ELT(R_col[4],row,mkCharLen(name,(int)len));
+			SET_STRING_ELT(R_col[5],row,node>=0 ? symbol_string(net,net->node_Layer[node]) : NA_STRING);
+			SET_STRING_ELT(R_col[6],row,edge>=0 ? symbol_string(net,net->edge_interaction[edge]) : NA_STRING);
+			SET_STRING_ELT(R_col[7],row,edge>=0 ? symbol_string(net,net->edge_Time[edge]) : NA_STRING);
+		}
+	}
+
+	as_data_frame(R_df,names,nrow);
+	UNPROTECT(1);
+	return R_df;
+}
+
+static SEXP named_list(SEXP R_list, const char **names, int n){
+	SEXP R_names;
+	int i;
+
+	R_names=PROTECT(allocVector(STRSXP,n));
+	for(i=0;i<n;i++)
+		SET_STRING_ELT(R_names,i,mkChar(names[i]));
+	setAttrib(R_list,R_NamesSymbol,R_names);
+
+	UNPROTECT(1);
+	return R_list;
+}
+
+/* The timings of the phases of the run, in seconds, and its counts. The
+   counts are doubles, as some can be beyond R's integers.
+*/
+static SEXP metrics_list(struct run *run){
+	static const char *names[]={"seconds","bytes_parsed","nodes_loaded","edges_loaded","names_resolved",
+	                            "names_missing","paths_loaded","hops_loaded","hop_pairs","nodes_flagged",
+	                            "edges_flagged","bytes_written","report_syscalls"};
+	const struct run_metrics *m=&run->metrics;
+	double counts[12];
+	SEXP R_list, R_seconds;
+	int i;
+
+	counts[0]=m->bytes_parsed;
+	counts[1]=m->nodes_loaded;
+	counts[2]=m->edges_loaded;
+	counts[3]=m->names_resolved;
+	counts[4]=m->names_missing;
+	counts[5]=m->paths_loaded;
+	counts[6]=m->hops_loaded;
+	counts[7]=m->hop_pairs;
+	counts[8]=m->nodes_flagged;
+	counts[9]=m->edges_flagged;
+	counts[10]=m->bytes_written;
+	counts[11]=m->report_syscalls;
+
+	R_list=PROTECT(allocVector(VECSXP,13));
+	SET_VECTOR_ELT(R_list,0,R_seconds=allocVector(REALSXP,NUM_PHASES));
+	for(i=0;i<NUM_PHASES;i++)
+		REAL(R_seconds)[i]=m->seconds[i];
+	named_list(R_seconds,(const char **)phase_names,NUM_PHASES);
+
+	for(i=0;i<12;i++)
+		SET_VECTOR_ELT(R_list,i+1,ScalarReal(counts[i]));
+
+	named_list(R_list,names,13);
+	UNPROTECT(1);
+	return R_list;
+}
+
+static SEXP run_results(void *data){
+	static const char *names[]={"nodes","edges","paths","metrics"};
+	struct run *run=data;
+	SEXP R_res;
+
+	R_res=PROTECT(allocVector(VECSXP,4));
+	SET_VECTOR_ELT(R_res,0,node_frame(run));
+	SET_VECTOR_ELT(R_res,1,edge_frame(run));
+	SET_VECTOR_ELT(R_res,2,path_frame(run));
+	SET_VECTOR_ELT(R_res,3,metrics_list(run));
+
+	named_list(R_res,names,4);
+	UNPROTECT(1);
+	return R_res;
+}
+
+static void run_cleanup(void *data){
+	release_run(data);
+}
+
+/* The paths of a run come from a paths file, or with a number for 'R_paths'
+   are that many shortest paths found over the network.
+*/
+static const char *paths_arg(SEXP R_paths, struct run_options *options){
+	if(isNumeric(R_paths) && length(R_paths)==1){
+		options->ksp_paths=asInteger(R_paths);
+		if(options->ksp_paths==NA_INTEGER || options->ksp_paths<1)
+			error("the number of paths must be a positive number");
+		return "";
+	}
+
+	check_strings(R_paths,1,"the paths file name or the number of paths");
+	return CHARPT(R_paths, 0);
+}
+
+/* The file to append the metrics of runs to, if any. */
+static const char *metrics_arg(SEXP R_metrics){
+	if(isNull(R_metrics))
+		return NULL;
+
+	check_strings(R_metrics,1,"the metrics file name");
+	return CHARPT(R_metrics, 0);
+}
+
+static void check_interrupt(void *data){
+	(void)data;
+	R_CheckUserInterrupt();
+}
+
+/* Whether the user has interrupted R. The interrupt is caught here rather than
+   jumping out of the run, which still has to let go of what it holds.
+*/
+static int r_interrupted(void){
+	return !R_ToplevelExec(check_interrupt,NULL);
+}
+
+/* Whether to follow the paths file while it is written: TRUE or FALSE, or
+   the number of seconds it may go without growing before it is complete.
+   The file is waited for until it is made or the user interrupts.
+*/
+static void follow_arg(SEXP R_follow, struct run_options *options){
+	options->interrupted=r_interrupted;
+
+	if(isNumeric(R_follow) && !isLogical(R_follow) && length(R_follow)==1){
+		options->follow=TRUE;
+		options->follow_idle=asReal(R_follow);
+		if(ISNAN(options->follow_idle) || options->follow_idle<0)
+			error("'follow' must be TRUE, FALSE or a number of seconds");
+		return;
+	}
+
+	options->follow=asLogical(R_follow);
+	if(options->follow==NA_LOGICAL)
+		error("'follow' must be TRUE, FALSE or a number of seconds");
+}
+
+static int compact_arg(SEXP R_compact){
+	int compact=asLogical(R_compact);
+
+	if(compact==NA_LOGICAL)
+		error("'compact' must be TRUE or FALSE");
+
+	return compact;
+}
+
+/* Process a paths file, or the shortest paths found for a number, against a
+   loaded network. Returns a list of data
+   frames with the flagged nodes and edges and the hops of every path; the
+   subset network and the text report are only written with 'R_files'.
+*/
+SEXP R_cytosub_run(SEXP R_net, SEXP R_paths, SEXP R_files, SEXP R_in_txt, SEXP R_out_cyjs, SEXP R_out_txt,
+                   SEXP R_threads, SEXP R_compact, SEXP R_metrics, SEXP R_follow){
+	struct network *net=network_handle(R_net);
+	struct run_files names;
+	struct run_options options;
+	struct run run;
+	int files;
+
+	check_strings(R_in_txt,1,"the in.txt file name");
+	check_strings(R_out_cyjs,1,"the output network file name");
+	check_strings(R_out_txt,1,"the output report file name");
+
+	files=asLogical(R_files);
+	if(files==NA_LOGICAL)
+		error("'files' must be TRUE or FALSE");
+
+	default_run_options(&options);
+	options.write_files=files;
+	options.num_threads=threads_arg(R_threads);
+	options.compact_json=compact_arg(R_compact);
+	options.metrics_file=metrics_arg(R_metrics);
+	follow_arg(R_follow,&options);
+
+	names.paths=paths_arg(R_paths,&options);
+	names.in_txt=CHARPT(R_in_txt, 0);
+	names.out_cyjs=CHARPT(R_out_cyjs, 0);
+	names.out_txt=CHARPT(R_out_txt, 0);
+
+	if(post_run_py_network(&run,net,&names,&options)!=0){
+		release_run(&run);
+		error("%s", last_out_message(&run.report));
+	}
+
+	/* the run is released however building the results ends */
+	return R_ExecWithCleanup(run_results,&run,run_cleanup,&run);
+}
+
+/* Process one job per paths file against a loaded network, each writing its
+   own output files. Returns the status of each job, 0 for success.
+*/
+SEXP R_cytosub_batch(SEXP R_net, SEXP R_paths, SEXP R_in_txt, SEXP R_out_cyjs, SEXP R_out_txt, SEXP R_threads,
+                     SEXP R_compact, SEXP R_metrics){
+	struct network *net=network_handle(R_net);
+	struct run_files *jobs;
+	struct run_options options;
+	SEXP R_status;
+	int i, num_jobs;
+
+	num_jobs=length(R_paths);
+	check_strings(R_paths,num_jobs,"the paths file names");
+	check_strings(R_in_txt,num_jobs,"the in.txt file names");
+	check_strings(R_out_cyjs,num_jobs,"the output network file names");
+	check_strings(R_out_txt,num_jobs,"the output report file names");
+	default_run_options(&options);
+	options.num_threads=threads_arg(R_threads);
+	options.compact_json=compact_arg(R_compact);
+	options.metrics_file=metrics_arg(R_metrics);
+
+	R_status=PROTECT(allocVector(INTSXP,num_jobs));
+	jobs=(struct run_files *)R_alloc(num_jobs+1,sizeof(*jobs));
+
+	for(i=0;i<num_jobs;i++){
+		jobs[i].paths=CHARPT(R_paths, i);
+		jobs[i].in_txt=CHARPT(R_in_txt, i);
+		jobs[i].out_cyjs=CHARPT(R_out_cyjs, i);
+		jobs[i].out_txt=CHARPT(R_out_txt, i);
+	}
+
+	post_run_py_batch(net,jobs,num_jobs,&options,INTEGER(R_status));
+
+	UNPROTECT(1);
+	return R_status;
+}
+
+/* A run kept between calls, to be extended as its paths file grows. The
+   file names are copied, as the R strings may not be around for as long.
+*/
+struct kept_run {
+	struct run run;
+	struct run_files files;
+	struct run_options options;
+	char names[];
+};
+
+static void kept_run_finalizer(SEXP R_run){
+	struct kept_run *kept=R_ExternalPtrAddr(R_run);
+
+	if(kept==NULL)
+		return;
+
+	release_run(&kept->run);
+	free(kept);
+	R_ClearExternalPtr(R_run);
+}
+
+static struct kept_run *kept_run_handle(SEXP R_run){
+	struct kept_run *kept;
+
+	if(TYPEOF(R_run)!=EXTPTRSXP || R_ExternalPtrTag(R_run)!=install("cytosub_run"))
+		error("not a cytosub run");
+
+	kept=R_ExternalPtrAddr(R_run);
+	if(kept==NULL)
+		error("the cytosub run has been stopped");
+
+	/* the network is the protected value of the handle */
+	network_handle(R_ExternalPtrProtected(R_run));
+
+	return kept;
+}
+
+/* Make a run against a loaded network and keep it, so that it can be
+   extended with the paths PathLinker adds to the paths file for a bigger k,
+   or with more shortest paths found.
+*/
+SEXP R_cytosub_start(SEXP R_net, SEXP R_paths, SEXP R_files, SEXP R_in_txt, SEXP R_out_cyjs, SEXP R_out_txt,
+                     SEXP R_threads, SEXP R_compact, SEXP R_metrics, SEXP R_follow){
+	struct network *net=network_handle(R_net);
+	struct kept_run *kept;
+	struct run_options options;
+	const char *names[5];
+	size_t len[5], size;
+	char *p;
+	char msg[MAX_LINE_LEN+1];
+	SEXP R_run;
+	int i, files;
+
+	check_strings(R_in_txt,1,"the in.txt file name");
+	check_strings(R_out_cyjs,1,"the output network file name");
+	check_strings(R_out_txt,1,"the output report file name");
+
+	files=asLogical(R_files);
+	if(files==NA_LOGICAL)
+		error("'files' must be TRUE or FALSE");
+
+	default_run_options(&options);
+	options.write_files=files;
+	options.num_threads=threads_arg(R_threads);
+	options.compact_json=compact_arg(R_compact);
+	follow_arg(R_follow,&options);
+
+	names[0]=paths_arg(R_paths,&options);
+	names[1]=CHARPT(R_in_txt, 0);
+	names[2]=CHARPT(R_out_cyjs, 0);
+	names[3]=CHARPT(R_out_txt, 0);
+	names[4]=metrics_arg(R_metrics);
+	if(names[4]==NULL)
+		names[4]="";
+
+	for(i=0,size=0;i<5;i++)
+		size+=(len[i]=strlen(names[i]))+1;
+
+	kept=malloc(sizeof(*kept)+size);
+	if(kept==NULL)
+		error("out of memory");
+
+	for(i=0,p=kept->names;i<5;i++){
+		memcpy(p,names[i],len[i]+1);
+		names[i]=p;
+		p+=len[i]+1;
+	}
+
+	kept->files.paths=names[0];
+	kept->files.in_txt=names[1];
+	kept->files.out_cyjs=names[2];
+	kept->files.out_txt=names[3];
+	kept->options=options;
+	kept->options.metrics_file=isNull(R_metrics) ? NULL : names[4];
+
+	if(post_run_py_network(&kept->run,net,&kept->files,&kept->options)!=0){
+		snprintf(msg,sizeof(msg),"%s",last_out_message(&kept->run.report));
+		release_run(&kept->run);
+		free(kept);
+		error("%s", msg);
+	}
+
+	R_run=PROTECT(R_MakeExternalPtr(kept,install("cytosub_run"),R_net));
+	R_RegisterCFinalizerEx(R_run,kept_run_finalizer,TRUE);
+	UNPROTECT(1);
+
+	return R_run;
+}
+
+/* Add the paths appended to the paths file of a kept run since it was made or
+   last extended, or for a run that finds its paths, find more up to 'R_k'.
+   Returns the same list of data frames as R_cytosub_run(), for all the paths
+   of the run.
+*/
+SEXP R_cytosub_extend(SEXP R_run, SEXP R_k){
+	struct kept_run *kept=kept_run_handle(R_run);
+	int k;
+
+	if(!isNull(R_k)){
+		if(kept->options.ksp_paths==0)
+			error("the run reads its paths from a file");
+
+		k=asInteger(R_k);
+		if(k==NA_INTEGER || k<1)
+			error("the number of paths must be a positive number");
+
+		kept->options.ksp_paths=k;
+	}
+
+	if(post_run_py_extend(&kept->run,&kept->options)!=0)
+		error("%s", last_out_message(&kept->run.report));
+
+	return run_results(&kept->run);
+}
+
+SEXP R_cytosub_stop(SEXP R_run){
+	kept_run_handle(R_run);
+	kept_run_finalizer(R_run);
+
+	return R_NilValue;
+}
+
+SEXP R_cytosub_close(SEXP R_net){
+	network_handle(R_net);
+	network_finalizer(R_net);
+
+	return R_NilValue;
+}
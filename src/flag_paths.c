@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "post_run_py.h"
+
+/* flag_paths.c
+
+   Resolves the edges of the detected paths against the network and flags the
+   nodes and edges on them for output. The work is done once per distinct
+   pair of a node and the next one on a path (see path_list.c), not once per
+   hop, as the paths share most of their hops. Pairs are independent of each
+   other, so with more than one thread they are cut into even runs and each
+   thread takes one. The network's lookup tables are only read, each pair's
+   edge is only written by the thread that owns the pair, and every thread
+   flags into bitsets of its own which are OR'ed together at the end, so the
+   result is the same as flagging serially. Those bitsets cost as much to
+   clear and merge as the whole network, so each thread gets at least
+   MIN_JOB_PAIRS pairs, and the few pairs of a chunk of a followed paths
+   file are flagged on the calling thread alone.
+*/
+
+#define  MAX_FLAG_THREADS         (64)
+#define  MIN_JOB_PAIRS            (4096)
+
+struct flag_job {
+	struct network * net;
+	struct path_list * paths;
+	int    first;
+	int    last;
+	unsigned int * node_output;
+	unsigned int * edge_output;
+};
+
+/* Flag pairs 'first' up to 'last' of the job.
+*/
+static void * flag_pairs( void * arg ) {
+	struct flag_job * job = arg;
+	struct network * net = job->net;
+	struct path_list * paths = job->paths;
+	int    from;
+	int    to;
+	int    edge;
+	int    i;
+
+	for (i = job->first; i < job->last; i++) {
+		from = paths->pair_from[i];
+		to = paths->pair_to[i];
+
+		/* flag both nodes for output */
+		bit_set( job->node_output, from );
+		bit_set( job->node_output, to );
+
+		/* and resolve the edge between them, which is kept for the report */
+		edge = find_edge( &net->adj, net->node_id[from], net->node_id[to] );
+
+		if (edge >= 0) {
+		    /* flag this edge for output */
+			paths->pair_edge[i] = edge;
+			bit_set( job->edge_output, edge );
+		}
+	}
+
+	return NULL;
+}
+
+/* Flag any node and edge that appears on a path detected by 'run_py', using
+   up to 'num_threads' threads. Only the paths from 'first_path' on, which
+   haven't been flagged before, are looked at, and of their pairs only the
+   ones they were the first to make. Returns -1 if out of memory.
+*/
+int flag_nodes_and_edges( struct run * run, int first_path, int num_threads ) {
+	struct network * net = run->net;
+	struct path_list * paths = &run->paths;
+	struct flag_job jobs[MAX_FLAG_THREADS];
+	pthread_t threads[MAX_FLAG_THREADS];
+	int    started[MAX_FLAG_THREADS];
+	long   hop;
+	int    first_pair;
+	int    num_pairs;
+	int    num_jobs;
+	int    ret;
+	int    t;
+	int    w;
+
+	if (first_path >= paths->num_paths) {
+		run->paths_flagged = paths->num_paths;
+		return 0;
+	}
+
+	/* a node on a path with no pair, next to names that aren't in the
+	   network or alone on it, is flagged here */
+	for (hop = paths->path_start[first_path]; hop < paths->num_hops; hop++)
+		if (paths->hop_node[hop] >= 0 && paths->hop_pair[hop] < 0 &&
+		    (hop == 0 || paths->hop_pair[hop - 1] < 0))
+			bit_set( run->node_output, paths->hop_node[hop] );
+
+	first_pair = paths->pairs_before[first_path];
+	num_pairs = paths->num_pairs - first_pair;
+
+	num_jobs = num_threads;
+
+	if (num_jobs > MAX_FLAG_THREADS)
+		num_jobs = MAX_FLAG_THREADS;
+
+	if (num_jobs > num_pairs / MIN_JOB_PAIRS)
+		num_jobs = num_pairs / MIN_JOB_PAIRS;
+
+	if (num_jobs < 1)
+		num_jobs = 1;
+
+	/* cut the pairs into even runs; the first job flags straight into the
+	   run's bitsets, the others into bitsets that are freed once merged */
+	ret = 0;
+
+	for (t = 0; t < num_jobs; t++) {
+		jobs[t].net = net;
+		jobs[t].paths = paths;
+		jobs[t].first = first_pair + (int) ((long) num_pairs * t / num_jobs);
+		jobs[t].last = first_pair + (int) ((long) num_pairs * (t + 1) / num_jobs);
+
+		if (t == 0) {
+			jobs[t].node_output = run->node_output;
+			jobs[t].edge_output = run->edge_output;
+		}
+		else {
+			/* a word more, so that an empty network isn't taken for no memory */
+			jobs[t].node_output = (unsigned int *) calloc( BIT_WORDS( net->num_nodes ) + 1, sizeof( unsigned int ) );
+			jobs[t].edge_output = (unsigned int *) calloc( BIT_WORDS( net->num_edges ) + 1, sizeof( unsigned int ) );
+
+			if (jobs[t].node_output == NULL || jobs[t].edge_output == NULL) {
+				num_jobs = t + 1;
+				ret = -1;
+			}
+		}
+	}
+
+	if (ret != 0)
+		goto free_jobs;
+
+	/* a thread that can't be started has its job done here instead */
+	for (t = 1; t < num_jobs; t++)
+		started[t] = (pthread_create( &threads[t], NULL, flag_pairs, &jobs[t] ) == 0);
+
+	flag_pairs( &jobs[0] );
+
+	for (t = 1; t < num_jobs; t++) {
+		if (started[t])
+			pthread_join( threads[t], NULL );
+		else
+			flag_pairs( &jobs[t] );
+
+		for (w = 0; w < BIT_WORDS( net->num_nodes ); w++)
+			run->node_output[w] |= jobs[t].node_output[w];
+
+		for (w = 0; w < BIT_WORDS( net->num_edges ); w++)
+			run->edge_output[w] |= jobs[t].edge_output[w];
+	}
+
+	run->paths_flagged = paths->num_paths;
+
+free_jobs:
+	for (t = 1; t < num_jobs; t++) {
+		free( jobs[t].node_output );
+		free( jobs[t].edge_output );
+	}
+
+	if (ret != 0) {
+		printf( "could not allocate the path flagging jobs\n" );
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
+	}
+
+	return ret;
+}
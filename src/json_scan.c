@@ -0,0 +1,473 @@
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "post_run_py.h"
+
+/* json_scan.c
+
+   A single pass JSON tokenizer that doesn't care how the document is laid out,
+   so both Cytoscape's pretty printed exports and compact JSON can be read. It
+   works on a buffer holding the whole document (normally the mapped network
+   file) and reports each token to a callback as it goes, without building any
+   tree of its own.
+
+   The inner loops, skipping whitespace and finding the end of a string, look at
+   16 bytes at a time with SSE2 where it is available.
+
+   For parsing a document in pieces there is also json_skip(), which finds
+   the end of an array or object by looking only at brackets and strings, and
+   json_scan_list(), which tokenizes a run of array elements cut out of a
+   document.
+*/
+
+#define  EXPECT_VALUE             (0)
+#define  EXPECT_FIRST_VALUE       (1)
+#define  EXPECT_KEY               (2)
+#define  EXPECT_FIRST_KEY         (3)
+#define  EXPECT_COLON             (4)
+#define  EXPECT_COMMA             (5)
+#define  EXPECT_NOTHING           (6)
+
+#if defined(__SSE2__)
+static int first_bit( unsigned int mask ) {
+	return __builtin_ctz( mask );
+}
+#endif
+
+static int is_ws( char c ) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/* Skip whitespace, returning the first other character or 'end'.
+*/
+static const char * skip_ws( const char * p, const char * end ) {
+#if defined(__SSE2__)
+	__m128i chunk;
+	unsigned int mask;
+#endif
+
+	/* compact JSON has no whitespace at all, so check the first byte on its own */
+	if (p < end && !is_ws( *p ))
+		return p;
+
+#if defined(__SSE2__)
+	while (end - p >= 16) {
+		chunk = _mm_loadu_si128( (const __m128i *) p );
+		mask = _mm_movemask_epi8( _mm_or_si128(
+		           _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( ' ' ) ),
+		                         _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\n' ) ) ),
+		           _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\r' ) ),
+		                         _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\t' ) ) ) ) );
+		mask = ~mask & 0xffff;
+
+		if (mask != 0)
+			return p + first_bit( mask );
+
+		p += 16;
+	}
+#endif
+
+	while (p < end && is_ws( *p ))
+		p++;
+
+	return p;
+}
+
+/* Find the closing quote of a string whose contents start at 'p'. Returns
+   NULL if the string isn't terminated.
+*/
+static const char * string_end( const char * p, const char * end ) {
+#if defined(__SSE2__)
+	__m128i chunk;
+	unsigned int mask;
+#endif
+
+	for (;;) {
+#if defined(__SSE2__)
+		while (end - p >= 16) {
+			chunk = _mm_loadu_si128( (const __m128i *) p );
+			mask = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '"' ) ),
+			                                        _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\\' ) ) ) );
+
+			if (mask != 0) {
+				p += first_bit( mask );
+				break;
+			}
+
+			p += 16;
+		}
+#endif
+
+		while (p < end && *p != '"' && *p != '\\')
+			p++;
+
+		if (p >= end)
+			return NULL;
+
+		if (*p == '"')
+			return p;
+
+		/* skip the escaped character, whatever it is */
+		p += 2;
+
+		if (p > end)
+			return NULL;
+	}
+}
+
+#if defined(__SSE2__)
+/* Bit i is set where data[i] is 'c', for 64 bytes.
+*/
+static unsigned long long match64( __m128i b0, __m128i b1, __m128i b2, __m128i b3, char c ) {
+	__m128i cc = _mm_set1_epi8( c );
+
+	return (unsigned long long) (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( b0, cc ) ) |
+	       (unsigned long long) (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( b1, cc ) ) << 16 |
+	       (unsigned long long) (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( b2, cc ) ) << 32 |
+	       (unsigned long long) (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( b3, cc ) ) << 48;
+}
+
+/* Bit i is the parity of bits 0 to i.
+*/
+static unsigned long long prefix_xor( unsigned long long x ) {
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+
+	return x;
+}
+#endif
+
+/* Find the bracket closing the array or object that opens at 'off', without
+   tokenizing what is inside it. Returns its offset, or (size_t) -1 if the
+   document ends first. Whether the contents are valid JSON is left to
+   whatever tokenizes them later.
+
+   With SSE2 this goes 64 bytes at a time: the quotes that aren't escaped
+   give, by a running parity, a mask of what is inside strings, and only the
+   brackets outside of it are looked at one by one.
+*/
+size_t json_skip( const char * data, size_t size, size_t off ) {
+	const char * p;
+	const char * end;
+	int    depth;
+	int    in_string;
+	int    escape_next;
+#if defined(__SSE2__)
+	__m128i b0, b1, b2, b3;
+	unsigned long long quotes;
+	unsigned long long escapes;
+	unsigned long long escaped;
+	unsigned long long strings;
+	unsigned long long opens;
+	unsigned long long closes;
+	unsigned long long brackets;
+	int    i;
+#endif
+
+	p = data + off + 1;
+	end = data + size;
+	depth = 1;
+	in_string = FALSE;
+	escape_next = FALSE;
+
+#if defined(__SSE2__)
+	while (end - p >= 64) {
+		b0 = _mm_loadu_si128( (const __m128i *) p );
+		b1 = _mm_loadu_si128( (const __m128i *) (p + 16) );
+		b2 = _mm_loadu_si128( (const __m128i *) (p + 32) );
+		b3 = _mm_loadu_si128( (const __m128i *) (p + 48) );
+
+		quotes = match64( b0, b1, b2, b3, '"' );
+		escapes = match64( b0, b1, b2, b3, '\\' );
+
+		/* escapes are rare enough to be worked out a byte at a time */
+		escaped = 0;
+
+		if (escapes != 0 || escape_next) {
+			for (i = 0; i < 64; i++) {
+				if (escape_next) {
+					escaped |= 1ull << i;
+					escape_next = FALSE;
+				}
+				else if (p[i] == '\\')
+					escape_next = TRUE;
+			}
+		}
+
+		strings = prefix_xor( quotes & ~escaped );
+
+		if (in_string)
+			strings = ~strings;
+
+		in_string = (int) (strings >> 63);
+
+		opens = match64( b0, b1, b2, b3, '{' ) | match64( b0, b1, b2, b3, '[' );
+		closes = match64( b0, b1, b2, b3, '}' ) | match64( b0, b1, b2, b3, ']' );
+
+		for (brackets = (opens | closes) & ~strings; brackets != 0; brackets &= brackets - 1) {
+			i = __builtin_ctzll( brackets );
+
+			if ((closes >> i) & 1) {
+				if (--depth == 0)
+					return p + i - data;
+			}
+			else
+				depth++;
+		}
+
+		p += 64;
+	}
+#endif
+
+	for (; p < end; p++) {
+		if (in_string) {
+			if (escape_next)
+				escape_next = FALSE;
+			else if (*p == '\\')
+				escape_next = TRUE;
+			else if (*p == '"')
+				in_string = FALSE;
+		}
+		else if (*p == '"')
+			in_string = TRUE;
+		else if (*p == '{' || *p == '[')
+			depth++;
+		else if (*p == '}' || *p == ']') {
+			if (--depth == 0)
+				return p - data;
+		}
+	}
+
+	return (size_t) -1;
+}
+
+/* Numbers and the literals true, false and null run up to the next
+   structural character or whitespace.
+*/
+static const char * scalar_end( const char * p, const char * end ) {
+	while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ':' && !is_ws( *p ))
+		p++;
+
+	return p;
+}
+
+static int scalar_type( const char * p, size_t len ) {
+	size_t i;
+
+	if (len == 4 && memcmp( p, "true", 4 ) == 0)
+		return JSON_TRUE;
+
+	if (len == 5 && memcmp( p, "false", 5 ) == 0)
+		return JSON_FALSE;
+
+	if (len == 4 && memcmp( p, "null", 4 ) == 0)
+		return JSON_NULL;
+
+	if (len == 0 || !(p[0] == '-' || (p[0] >= '0' && p[0] <= '9')))
+		return 0;
+
+	for (i = 1; i < len; i++) {
+		if (!((p[i] >= '0' && p[i] <= '9') || p[i] == '.' || p[i] == 'e' || p[i] == 'E' ||
+		      p[i] == '+' || p[i] == '-'))
+			return 0;
+	}
+
+	return JSON_NUMBER;
+}
+
+/* Tokenize 'data' as a whole document or, with 'in_list', as the elements of
+   an array without the brackets around them.
+*/
+static int scan( const char * data, size_t size, json_event_fn event, void * user, size_t * stop_off, int in_list ) {
+	const char * p;
+	const char * end;
+	const char * tok_end;
+	char   stack[JSON_MAX_DEPTH];
+	size_t close_off;
+	int    base;
+	int    depth;
+	int    state;
+	int    type;
+	int    ret;
+
+	p = data;
+	end = data + size;
+	ret = 0;
+
+	if (in_list) {
+		/* the list's own brackets give no events and can't be closed */
+		stack[0] = '[';
+		base = 1;
+		state = EXPECT_FIRST_VALUE;
+	}
+	else {
+		base = 0;
+		state = EXPECT_VALUE;
+	}
+
+	depth = base;
+
+	for (;;) {
+		p = skip_ws( p, end );
+
+		if (p >= end)
+			break;
+
+		switch (*p) {
+		case '{':
+		case '[':
+			if (state != EXPECT_VALUE && state != EXPECT_FIRST_VALUE)
+				goto syntax_error;
+
+			if (depth >= JSON_MAX_DEPTH)
+				goto syntax_error;
+
+			stack[depth++] = *p;
+			type = (*p == '{') ? JSON_OBJECT_START : JSON_ARRAY_START;
+			state = (*p == '{') ? EXPECT_FIRST_KEY : EXPECT_FIRST_VALUE;
+
+			if ((ret = event( user, type, p, 1 )) != 0) {
+				if (ret != JSON_SKIP)
+					goto stopped;
+
+				/* carry on from the closing bracket, as if the contents had been read */
+				close_off = json_skip( data, size, p - data );
+
+				if (close_off == (size_t) -1)
+					goto syntax_error;
+
+				p = data + close_off;
+				state = EXPECT_COMMA;
+				ret = 0;
+				break;
+			}
+
+			p++;
+			break;
+
+		case '}':
+		case ']':
+			if (depth == base || stack[depth - 1] != ((*p == '}') ? '{' : '['))
+				goto syntax_error;
+
+			if (state != EXPECT_COMMA &&
+			    !(*p == '}' && state == EXPECT_FIRST_KEY) &&
+			    !(*p == ']' && state == EXPECT_FIRST_VALUE))
+				goto syntax_error;
+
+			depth--;
+			state = (depth == 0) ? EXPECT_NOTHING : EXPECT_COMMA;
+
+			if ((ret = event( user, (*p == '}') ? JSON_OBJECT_END : JSON_ARRAY_END, p, 1 )) != 0)
+				goto stopped;
+
+			p++;
+			break;
+
+		case ',':
+			if (state != EXPECT_COMMA || depth == 0)
+				goto syntax_error;
+
+			state = (stack[depth - 1] == '{') ? EXPECT_KEY : EXPECT_VALUE;
+			p++;
+			break;
+
+		case ':':
+			if (state != EXPECT_COLON)
+				goto syntax_error;
+
+			state = EXPECT_VALUE;
+			p++;
+			break;
+
+		case '"':
+			tok_end = string_end( p + 1, end );
+
+			if (tok_end == NULL)
+				goto syntax_error;
+
+			if (state == EXPECT_KEY || state == EXPECT_FIRST_KEY) {
+				type = JSON_KEY;
+				state = EXPECT_COLON;
+			}
+			else if (state == EXPECT_VALUE || state == EXPECT_FIRST_VALUE) {
+				type = JSON_STRING;
+				state = (depth == 0) ? EXPECT_NOTHING : EXPECT_COMMA;
+			}
+			else
+				goto syntax_error;
+
+			if ((ret = event( user, type, p + 1, tok_end - p - 1 )) != 0)
+				goto stopped;
+
+			p = tok_end + 1;
+			break;
+
+		default:
+			if (state != EXPECT_VALUE && state != EXPECT_FIRST_VALUE)
+				goto syntax_error;
+
+			tok_end = scalar_end( p, end );
+			type = scalar_type( p, tok_end - p );
+
+			if (type == 0)
+				goto syntax_error;
+
+			state = (depth == 0) ? EXPECT_NOTHING : EXPECT_COMMA;
+
+			if ((ret = event( user, type, p, tok_end - p )) != 0)
+				goto stopped;
+
+			p = tok_end;
+			break;
+		}
+	}
+
+	if (in_list) {
+		/* a piece cut out of a list may end with the comma before the next element */
+		if (depth != base || (state != EXPECT_COMMA && state != EXPECT_VALUE && state != EXPECT_FIRST_VALUE))
+			goto syntax_error;
+	}
+	else if (depth != 0 || state != EXPECT_NOTHING)
+		goto syntax_error;
+
+	return 0;
+
+syntax_error:
+	ret = JSON_SYNTAX_ERROR;
+
+stopped:
+	if (stop_off != NULL)
+		*stop_off = ((p < end) ? p : end) - data;
+
+	return ret;
+}
+
+/* Tokenize 'data', calling 'event' for every token. Returns 0 when the whole
+   document was read, JSON_SYNTAX_ERROR if it isn't valid JSON, or whatever
+   non-zero value the callback returned to stop the scan. In the last two cases
+   'stop_off' (if not NULL) is set to the offset the scan stopped at.
+
+   A callback that gets an object or array start can return JSON_SKIP to have
+   its contents passed over without events; the scan goes on with the end of
+   the container.
+*/
+int json_scan( const char * data, size_t size, json_event_fn event, void * user, size_t * stop_off ) {
+	return scan( data, size, event, user, stop_off, FALSE );
+}
+
+/* Like json_scan(), for a run of array elements separated by commas, such as
+   a piece cut out of a list between two elements. There are no events for
+   the list itself. The piece may end with the comma before the element that
+   follows it.
+*/
+int json_scan_list( const char * data, size_t size, json_event_fn event, void * user, size_t * stop_off ) {
+	return scan( data, size, event, user, stop_off, TRUE );
+}
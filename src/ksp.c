@@ -0,0 +1,755 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "post_run_py.h"
+
+/* ksp.c
+
+   Finds the k shortest simple paths from the source nodes to the target nodes
+   of 'in.txt' over the loaded network itself, the way PathLinker's 'run.py'
+   does, so that the paths don't have to go through a paths file. As in
+   PathLinker a super source is joined to every source and every target to a
+   super sink, edges going into a source or out of a target are left out, and
+   the paths are found by Yen's algorithm between the two super nodes. Nodes
+   flagged isExcludedFromPaths are left out altogether.
+
+   The network has no edge weights, so every edge costs 1, which is what
+   PathLinker does with unweighted networks: the paths come shortest first.
+   Paths of the same length come in the order they were found, so the result
+   is always the same for the same network and 'in.txt'.
+
+   The search is kept with the run, and asking for more paths later carries
+   on from where it stopped, see post_run_py_extend().
+*/
+
+/* A path from the super source to the super sink. 'dist' is the cost up to
+   each node, and 'dev' the node where the path leaves the path it was found
+   as a deviation of; only later nodes are tried as spur nodes for it. */
+struct found_path {
+	double cost;
+	int    len;
+	int    dev;
+	int    serial;
+	unsigned int hash;
+	int  * nodes;
+	double * dist;
+	struct found_path * next_hash;
+};
+
+struct heap_entry {
+	double dist;
+	int    node;
+};
+
+/* A prefix of the paths found: its last node and the prefix before it, -1
+   for none. Its children are the prefixes one node longer, so the paths
+   that share a root with a spur node are found without looking at others. */
+struct path_prefix {
+	int    node;
+	int    parent;
+	int    first_child;
+	int    next_sibling;
+	int    next_hash;
+};
+
+/* The search graph is the network by node index plus the super source and
+   sink, the last two nodes, in CSR form. 'col_edge' is the network edge of an
+   entry, or -1 for an edge from the super source or to the super sink. */
+struct path_search {
+	int    num_nodes;
+	int    source;
+	int    sink;
+	int  * row_start;
+	int  * col_node;
+	int  * col_edge;
+
+	/* Dijkstra's working arrays; an entry of the stamp arrays is only valid
+	   when it equals 'stamp', so none of them need clearing between runs */
+	double * dist;
+	int  * prev;
+	int  * reached;
+	int  * settled;
+	int  * cut;
+	int    stamp;
+	struct heap_entry * heap;
+
+	/* the paths found so far, shortest first, and the candidates for the
+	   next one in a heap */
+	struct found_path ** found;
+	int    num_found;
+	int    found_cap;
+	struct found_path ** cand;
+	int    num_cand;
+	int    cand_cap;
+	int    serial;
+	int    exhausted;
+
+	/* every path found or a candidate, so none is added twice */
+	struct found_path ** buckets;
+	int    num_buckets;
+	int    num_hashed;
+
+	/* the prefixes of the paths found as a trie, hashed by parent and node */
+	struct path_prefix * prefixes;
+	int    num_prefixes;
+	int    prefix_cap;
+	int  * prefix_buckets;
+	int    num_prefix_buckets;
+};
+
+struct id_entry {
+	int id;
+	int node;
+};
+
+static int compare_id_entries( const void * a, const void * b ) {
+	const struct id_entry * ea = a;
+	const struct id_entry * eb = b;
+
+	if (ea->id != eb->id)
+		return (ea->id < eb->id) ? -1 : 1;
+
+	/* of nodes sharing an id, the last one in the file first */
+	return (ea->node > eb->node) ? -1 : (ea->node < eb->node);
+}
+
+/* The node with id 'id', or -1. */
+static int id_node( const struct id_entry * ids, int num, int id ) {
+	int lo;
+	int hi;
+	int mid;
+
+	lo = 0;
+	hi = num;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (ids[mid].id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (lo < num && ids[lo].id == id) ? ids[lo].node : -1;
+}
+
+/* Whether the network edge from node 'u' to node 'v' can be on a path. */
+static int usable_edge( struct run * run, int u, int v ) {
+	struct network * net = run->net;
+
+	return u != v && v >= 0 &&
+	       !bit_test( net->node_isExcludedFromPaths, u ) && !bit_test( net->node_isExcludedFromPaths, v ) &&
+	       !bit_test( run->node_target, u ) && !bit_test( run->node_source, v );
+}
+
+/* Build the search graph from the network's adjacency. Of parallel edges only
+   the one find_edge() gives is kept, so the paths use the edges they are
+   reported with.
+*/
+static int build_search_graph( struct run * run, struct path_search * search ) {
+	struct network * net = run->net;
+	struct edge_adjacency * adj = &net->adj;
+	struct id_entry * ids;
+	int  * pos;
+	int    num_nodes;
+	int    row;
+	int    col;
+	int    u;
+	int    v;
+	int    i;
+	int    pass;
+
+	num_nodes = net->num_nodes;
+	search->num_nodes = num_nodes + 2;
+	search->source = num_nodes;
+	search->sink = num_nodes + 1;
+	search->row_start = (int *) arena_calloc( &run->arena, num_nodes + 3, sizeof( int ) );
+	/* only needed while building */
+	ids = (struct id_entry *) malloc( (num_nodes + 1) * sizeof( struct id_entry ) );
+	pos = (int *) malloc( (num_nodes + 3) * sizeof( int ) );
+
+	if (search->row_start == NULL || ids == NULL || pos == NULL)
+		goto out_of_memory;
+
+	for (i = 0; i < num_nodes; i++) {
+		ids[i].id = net->node_id[i];
+		ids[i].node = i;
+	}
+
+	qsort( ids, num_nodes, sizeof( struct id_entry ), compare_id_entries );
+
+	/* count the entries of each row on the first pass and fill them in on
+	   the second */
+	for (pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			for (u = 0; u < search->num_nodes; u++)
+				search->row_start[u + 1] += search->row_start[u];
+
+			memcpy( pos, search->row_start, (search->num_nodes + 1) * sizeof( int ) );
+			search->col_node = (int *) arena_alloc( &run->arena, (search->row_start[search->num_nodes] + 1) * sizeof( int ) );
+			search->col_edge = (int *) arena_alloc( &run->arena, (search->row_start[search->num_nodes] + 1) * sizeof( int ) );
+
+			if (search->col_node == NULL || search->col_edge == NULL)
+				goto out_of_memory;
+		}
+
+		for (row = 0; row < adj->num_rows; row++) {
+			u = id_node( ids, num_nodes, adj->row_source[row] );
+
+			if (u < 0)
+				continue;
+
+			for (col = adj->row_start[row]; col < adj->row_start[row + 1]; col++) {
+				if (col > adj->row_start[row] && adj->col_target[col] == adj->col_target[col - 1])
+					continue;
+
+				v = id_node( ids, num_nodes, adj->col_target[col] );
+
+				if (!usable_edge( run, u, v ))
+					continue;
+
+				if (pass == 0)
+					search->row_start[u + 1]++;
+				else {
+					search->col_node[pos[u]] = v;
+					search->col_edge[pos[u]++] = adj->col_edge[col];
+				}
+			}
+		}
+
+		for (u = 0; u < num_nodes; u++) {
+			if (bit_test( net->node_isExcludedFromPaths, u ))
+				continue;
+
+			/* the edges of the super source come after the network's, which
+			   only matters to the order of the row */
+			if (bit_test( run->node_source, u )) {
+				if (pass == 0)
+					search->row_start[search->source + 1]++;
+				else {
+					search->col_node[pos[search->source]] = u;
+					search->col_edge[pos[search->source]++] = -1;
+				}
+			}
+
+			if (bit_test( run->node_target, u )) {
+				if (pass == 0)
+					search->row_start[u + 1]++;
+				else {
+					search->col_node[pos[u]] = search->sink;
+					search->col_edge[pos[u]++] = -1;
+				}
+			}
+		}
+	}
+
+	free( ids );
+	free( pos );
+	return 0;
+
+out_of_memory:
+	free( ids );
+	free( pos );
+	return -1;
+}
+
+static int init_search( struct run * run, struct path_search * search ) {
+	int    n;
+
+	memset( search, 0, sizeof( struct path_search ) );
+
+	if (build_search_graph( run, search ) != 0)
+		return -1;
+
+	n = search->num_nodes;
+	search->dist = (double *) arena_alloc( &run->arena, n * sizeof( double ) );
+	search->prev = (int *) arena_alloc( &run->arena, n * sizeof( int ) );
+	search->reached = (int *) arena_calloc( &run->arena, n, sizeof( int ) );
+	search->settled = (int *) arena_calloc( &run->arena, n, sizeof( int ) );
+	search->cut = (int *) arena_calloc( &run->arena, n, sizeof( int ) );
+	/* every entry pushed is for an edge relaxed, and each edge is relaxed at
+	   most once */
+	search->heap = (struct heap_entry *) arena_alloc( &run->arena, (search->row_start[n] + 1) * sizeof( struct heap_entry ) );
+
+	return (search->dist == NULL || search->prev == NULL || search->reached == NULL ||
+	        search->settled == NULL || search->cut == NULL || search->heap == NULL) ? -1 : 0;
+}
+
+static void heap_push( struct heap_entry * heap, int * num, double dist, int node ) {
+	int    i;
+	int    parent;
+
+	for (i = (*num)++; i > 0; i = parent) {
+		parent = (i - 1) / 2;
+
+		if (heap[parent].dist < dist || (heap[parent].dist == dist && heap[parent].node <= node))
+			break;
+
+		heap[i] = heap[parent];
+	}
+
+	heap[i].dist = dist;
+	heap[i].node = node;
+}
+
+static struct heap_entry heap_pop( struct heap_entry * heap, int * num ) {
+	struct heap_entry top;
+	struct heap_entry last;
+	int    i;
+	int    child;
+
+	top = heap[0];
+	last = heap[--(*num)];
+
+	for (i = 0; (child = 2 * i + 1) < *num; i = child) {
+		if (child + 1 < *num &&
+		    (heap[child + 1].dist < heap[child].dist ||
+		     (heap[child + 1].dist == heap[child].dist && heap[child + 1].node < heap[child].node)))
+			child++;
+
+		if (last.dist < heap[child].dist || (last.dist == heap[child].dist && last.node <= heap[child].node))
+			break;
+
+		heap[i] = heap[child];
+	}
+
+	heap[i] = last;
+	return top;
+}
+
+/* Dijkstra's shortest path from 'from', which has cost 'dist' already, to the
+   super sink. Nodes already marked settled for the current stamp are kept
+   off the path, as are the edges from 'from' to nodes marked cut. Returns
+   whether the sink was reached; the path is then in 'prev'.
+*/
+static int shortest_path( struct path_search * search, int from, double dist ) {
+	struct heap_entry top;
+	double next_dist;
+	int    num;
+	int    col;
+	int    u;
+	int    v;
+
+	num = 0;
+	search->reached[from] = search->stamp;
+	search->dist[from] = dist;
+	search->prev[from] = -1;
+	heap_push( search->heap, &num, dist, from );
+
+	while (num > 0) {
+		top = heap_pop( search->heap, &num );
+		u = top.node;
+
+		if (search->settled[u] == search->stamp)
+			continue;
+
+		search->settled[u] = search->stamp;
+
+		if (u == search->sink)
+			return TRUE;
+
+		for (col = search->row_start[u]; col < search->row_start[u + 1]; col++) {
+			v = search->col_node[col];
+
+			if (search->settled[v] == search->stamp || (u == from && search->cut[v] == search->stamp))
+				continue;
+
+			next_dist = top.dist + ((search->col_edge[col] >= 0) ? 1.0 : 0.0);
+
+			if (search->reached[v] != search->stamp || next_dist < search->dist[v]) {
+				search->reached[v] = search->stamp;
+				search->dist[v] = next_dist;
+				search->prev[v] = u;
+				heap_push( search->heap, &num, next_dist, v );
+			}
+		}
+	}
+
+	return FALSE;
+}
+
+/* Make room for one more entry in an array that lives in the arena. The old
+   array is left behind; doubling keeps that to as much again as is used. */
+static void * grow_array( struct arena * arena, void * array, int num, int * cap, size_t size ) {
+	void * grown;
+	int    cap2;
+
+	if (num < *cap)
+		return array;
+
+	cap2 = (*cap > 0) ? *cap * 2 : 64;
+	grown = arena_alloc( arena, cap2 * size );
+
+	if (grown != NULL) {
+		if (num > 0)
+			memcpy( grown, array, num * size );
+
+		*cap = cap2;
+	}
+
+	return grown;
+}
+
+static int same_nodes( const struct found_path * a, const struct found_path * b ) {
+	return a->len == b->len && memcmp( a->nodes, b->nodes, a->len * sizeof( int ) ) == 0;
+}
+
+/* Add 'path' to the paths seen unless an equal one is there already. Returns
+   1 if it was added, 0 if not and -1 if out of memory.
+*/
+static int hash_path( struct arena * arena, struct path_search * search, struct found_path * path ) {
+	struct found_path ** buckets;
+	struct found_path * cur;
+	struct found_path * next;
+	int    num_buckets;
+	int    i;
+
+	path->hash = hash_name( (const char *) path->nodes, path->len * sizeof( int ) );
+
+	if (search->num_buckets > 0) {
+		for (cur = search->buckets[path->hash & (search->num_buckets - 1)]; cur != NULL; cur = cur->next_hash) {
+			if (cur->hash == path->hash && same_nodes( cur, path ))
+				return 0;
+		}
+	}
+
+	if (search->num_hashed >= search->num_buckets) {
+		num_buckets = (search->num_buckets > 0) ? search->num_buckets * 2 : 256;
+		buckets = (struct found_path **) arena_calloc( arena, num_buckets, sizeof( struct found_path * ) );
+
+		if (buckets == NULL)
+			return -1;
+
+		for (i = 0; i < search->num_buckets; i++) {
+			for (cur = search->buckets[i]; cur != NULL; cur = next) {
+				next = cur->next_hash;
+				cur->next_hash = buckets[cur->hash & (num_buckets - 1)];
+				buckets[cur->hash & (num_buckets - 1)] = cur;
+			}
+		}
+
+		search->buckets = buckets;
+		search->num_buckets = num_buckets;
+	}
+
+	path->next_hash = search->buckets[path->hash & (search->num_buckets - 1)];
+	search->buckets[path->hash & (search->num_buckets - 1)] = path;
+	search->num_hashed++;
+
+	return 1;
+}
+
+static unsigned int prefix_hash( int parent, int node ) {
+	int    key[2];
+
+	key[0] = parent;
+	key[1] = node;
+	return hash_name( (const char *) key, sizeof( key ) );
+}
+
+/* The prefix that is 'parent' followed by 'node', or -1. */
+static int find_prefix( const struct path_search * search, int parent, int node ) {
+	int    i;
+
+	if (search->num_prefix_buckets == 0)
+		return -1;
+
+	for (i = search->prefix_buckets[prefix_hash( parent, node ) & (search->num_prefix_buckets - 1)];
+	     i >= 0; i = search->prefixes[i].next_hash)
+	{
+		if (search->prefixes[i].parent == parent && search->prefixes[i].node == node)
+			return i;
+	}
+
+	return -1;
+}
+
+/* Add the prefixes of a path found that aren't in the trie yet. Returns -1
+   if out of memory.
+*/
+static int add_prefixes( struct arena * arena, struct path_search * search, const struct found_path * path ) {
+	struct path_prefix * prefix;
+	unsigned int h;
+	int    num_buckets;
+	int    parent;
+	int    p;
+	int    i;
+
+	for (parent = -1, i = 0; i < path->len; parent = p, i++) {
+		if ((p = find_prefix( search, parent, path->nodes[i] )) >= 0)
+			continue;
+
+		if (search->num_prefixes >= search->num_prefix_buckets) {
+			num_buckets = (search->num_prefix_buckets > 0) ? search->num_prefix_buckets * 2 : 256;
+			search->prefix_buckets = (int *) arena_alloc( arena, num_buckets * sizeof( int ) );
+
+			if (search->prefix_buckets == NULL)
+				return -1;
+
+			memset( search->prefix_buckets, 0xff, num_buckets * sizeof( int ) );
+			search->num_prefix_buckets = num_buckets;
+
+			for (p = 0; p < search->num_prefixes; p++) {
+				h = prefix_hash( search->prefixes[p].parent, search->prefixes[p].node ) & (num_buckets - 1);
+				search->prefixes[p].next_hash = search->prefix_buckets[h];
+				search->prefix_buckets[h] = p;
+			}
+		}
+
+		search->prefixes = grow_array( arena, search->prefixes, search->num_prefixes, &search->prefix_cap,
+		                               sizeof( struct path_prefix ) );
+
+		if (search->prefixes == NULL)
+			return -1;
+
+		p = search->num_prefixes++;
+		prefix = &search->prefixes[p];
+		prefix->node = path->nodes[i];
+		prefix->parent = parent;
+		prefix->first_child = -1;
+		prefix->next_sibling = -1;
+
+		if (parent >= 0) {
+			prefix->next_sibling = search->prefixes[parent].first_child;
+			search->prefixes[parent].first_child = p;
+		}
+
+		h = prefix_hash( parent, prefix->node ) & (search->num_prefix_buckets - 1);
+		prefix->next_hash = search->prefix_buckets[h];
+		search->prefix_buckets[h] = p;
+	}
+
+	return 0;
+}
+
+/* Cheaper first, then the one found first. */
+static int path_before( const struct found_path * a, const struct found_path * b ) {
+	return a->cost < b->cost || (a->cost == b->cost && a->serial < b->serial);
+}
+
+static int push_candidate( struct arena * arena, struct path_search * search, struct found_path * path ) {
+	int    i;
+	int    parent;
+
+	search->cand = grow_array( arena, search->cand, search->num_cand, &search->cand_cap, sizeof( struct found_path * ) );
+
+	if (search->cand == NULL)
+		return -1;
+
+	for (i = search->num_cand++; i > 0 && path_before( path, search->cand[parent = (i - 1) / 2] ); i = parent)
+		search->cand[i] = search->cand[parent];
+
+	search->cand[i] = path;
+	return 0;
+}
+
+static struct found_path * pop_candidate( struct path_search * search ) {
+	struct found_path * top;
+	struct found_path * last;
+	int    i;
+	int    child;
+
+	top = search->cand[0];
+	last = search->cand[--search->num_cand];
+
+	for (i = 0; (child = 2 * i + 1) < search->num_cand; i = child) {
+		if (child + 1 < search->num_cand && path_before( search->cand[child + 1], search->cand[child] ))
+			child++;
+
+		if (!path_before( search->cand[child], last ))
+			break;
+
+		search->cand[i] = search->cand[child];
+	}
+
+	search->cand[i] = last;
+	return top;
+}
+
+/* Make a path of the first 'root_len' nodes of 'root' (none for the first
+   path) followed by the path shortest_path() just found to the sink.
+*/
+static struct found_path * make_path( struct arena * arena, struct path_search * search,
+                                      const struct found_path * root, int root_len )
+{
+	struct found_path * path;
+	int    spur_len;
+	int    u;
+	int    i;
+
+	spur_len = 0;
+
+	for (u = search->sink; u >= 0; u = search->prev[u])
+		spur_len++;
+
+	path = (struct found_path *) arena_alloc( arena, sizeof( struct found_path ) );
+
+	if (path == NULL)
+		return NULL;
+
+	path->len = root_len + spur_len;
+	path->dev = (root_len > 0) ? root_len - 1 : 0;
+	path->serial = search->serial++;
+	path->nodes = (int *) arena_alloc( arena, path->len * sizeof( int ) );
+	path->dist = (double *) arena_alloc( arena, path->len * sizeof( double ) );
+	path->next_hash = NULL;
+
+	if (path->nodes == NULL || path->dist == NULL)
+		return NULL;
+
+	/* the spur node ends the root and starts the spur path */
+	if (root_len > 0) {
+		memcpy( path->nodes, root->nodes, (root_len - 1) * sizeof( int ) );
+		memcpy( path->dist, root->dist, (root_len - 1) * sizeof( double ) );
+		path->len--;
+	}
+
+	for (i = path->len - 1, u = search->sink; u >= 0; i--, u = search->prev[u]) {
+		path->nodes[i] = u;
+		path->dist[i] = search->dist[u];
+	}
+
+	path->cost = path->dist[path->len - 1];
+	return path;
+}
+
+/* Yen's step: add the deviations of the latest path found to the
+   candidates. Each node of it from where it deviated from its own parent on
+   is tried as a spur node, with the nodes before it kept off the rest of the
+   path, and the edges out of it that paths with the same root already take
+   cut; those are the children of the root in the trie of prefixes.
+*/
+static int add_deviations( struct arena * arena, struct path_search * search ) {
+	struct found_path * last = search->found[search->num_found - 1];
+	struct found_path * path;
+	int    prefix;
+	int    child;
+	int    spur;
+	int    i;
+	int    ret;
+
+	for (prefix = -1, i = 0; i < last->dev; i++)
+		prefix = find_prefix( search, prefix, last->nodes[i] );
+
+	for (spur = last->dev; spur < last->len - 1; spur++) {
+		search->stamp++;
+
+		for (i = 0; i < spur; i++)
+			search->settled[last->nodes[i]] = search->stamp;
+
+		/* the path is in the trie, so all of its prefixes are */
+		prefix = find_prefix( search, prefix, last->nodes[spur] );
+
+		for (child = search->prefixes[prefix].first_child; child >= 0; child = search->prefixes[child].next_sibling)
+			search->cut[search->prefixes[child].node] = search->stamp;
+
+		if (!shortest_path( search, last->nodes[spur], last->dist[spur] ))
+			continue;
+
+		path = make_path( arena, search, last, spur + 1 );
+
+		if (path == NULL || (ret = hash_path( arena, search, path )) < 0)
+			return -1;
+
+		if (ret > 0 && push_candidate( arena, search, path ) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Add a path found after the run's paths, as load_out_paths() does with a
+   line of the paths file, its rank being its place in the order found.
+*/
+static int add_out_path( struct run * run, const struct found_path * path ) {
+	int    i;
+
+	if (begin_path( &run->paths, run->paths.num_paths + 1, path->cost ) != 0)
+		return -1;
+
+	/* without the super source and sink */
+	for (i = 1; i < path->len - 1; i++)
+		if (add_hop( &run->paths, path->nodes[i] ) != 0)
+			return -1;
+
+	return 0;
+}
+
+/* Find the shortest paths between the sources and targets 'process_in_nodes()'
+   has flagged until the run has 'k' paths, or there are no more, and put
+   them after the run's paths like load_out_paths() would. The search
+   carries on from the run's last call, if any. Returns 0, or -1 with a
+   message in the report.
+*/
+int find_shortest_paths( struct run * run, int k ) {
+	struct path_search * search = run->search;
+	struct found_path * path;
+	int    ret;
+
+	if (search == NULL) {
+		search = (struct path_search *) arena_alloc( &run->arena, sizeof( struct path_search ) );
+
+		if (search == NULL || init_search( run, search ) != 0)
+			goto out_of_memory;
+
+		run->search = search;
+	}
+
+	while (run->paths.num_paths < k && !search->exhausted) {
+		if (search->num_found == 0) {
+			search->stamp++;
+
+			if (!shortest_path( search, search->source, 0.0 )) {
+				search->exhausted = TRUE;
+				break;
+			}
+
+			path = make_path( &run->arena, search, NULL, 0 );
+
+			if (path == NULL || hash_path( &run->arena, search, path ) < 0)
+				goto out_of_memory;
+		}
+		else {
+			if (add_deviations( &run->arena, search ) != 0)
+				goto out_of_memory;
+
+			if (search->num_cand == 0) {
+				search->exhausted = TRUE;
+				break;
+			}
+
+			path = pop_candidate( search );
+		}
+
+		search->found = grow_array( &run->arena, search->found, search->num_found, &search->found_cap, sizeof( struct found_path * ) );
+
+		if (search->found == NULL)
+			goto out_of_memory;
+
+		search->found[search->num_found++] = path;
+
+		if (add_prefixes( &run->arena, search, path ) != 0)
+			goto out_of_memory;
+
+		if ((ret = add_out_path( run, path )) != 0)
+			goto out_of_memory;
+	}
+
+	if (run->paths.num_paths == 0) {
+		printf( "no paths between the sources and the targets\n" );
+
+		if (run->num_source != 0 && run->num_target != 0)
+			write_out_message( &run->report, "There are no paths between the specified source(s) and target(s).\n" );
+		else
+			write_out_message( &run->report, "Path analysis was not completed successfully." );
+	}
+
+	return 0;
+
+out_of_memory:
+	printf( "out of memory finding the shortest paths\n" );
+	write_out_message( &run->report, "Path analysis was not completed successfully." );
+	return -1;
+}
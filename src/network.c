@@ -0,0 +1,702 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "post_run_py.h"
+
+/* network.c
+
+   The column store behind struct network. Columns are grown together as the
+   loader adds records, doubling their capacity each time, and are all freed
+   (along with the mapping of the network file) by free_network(). The name
+   index and edge adjacency are built over the columns once loading is done.
+*/
+
+#define  MIN_CAPACITY             (1024)
+#define  MIN_POOL_SIZE            (64)
+
+/* FNV-1a, plenty good enough for gene names.
+*/
+unsigned int hash_name( const char * name, size_t len ) {
+	unsigned int h = 2166136261u;
+
+	while (len-- > 0) {
+		h ^= (unsigned char) *name++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+/* Put symbol 'sym' into the pool's hash table, which has room for it.
+*/
+static void pool_insert( struct network * net, int sym ) {
+	struct string_pool * pool = &net->pool;
+	struct str_view * str = &pool->strings[sym];
+	unsigned int mask;
+	unsigned int slot;
+
+	mask = pool->size - 1;
+
+	for (slot = hash_name( net->text + str->off, str->len ) & mask; pool->slots[slot] >= 0; slot = (slot + 1) & mask)
+		;
+
+	pool->slots[slot] = sym;
+}
+
+/* Return the symbol of the string at 'off' in the network file, adding it to
+   the pool if it hasn't been seen before. Returns -1 if out of memory.
+*/
+int intern_string( struct network * net, size_t off, size_t len ) {
+	struct string_pool * pool = &net->pool;
+	const char * text = net->text;
+	struct str_view * str;
+	unsigned int mask;
+	unsigned int slot;
+	int    sym;
+	int  * slots;
+	int    size;
+
+	if (pool->size > 0) {
+		mask = pool->size - 1;
+
+		for (slot = hash_name( text + off, len ) & mask; pool->slots[slot] >= 0; slot = (slot + 1) & mask) {
+			str = &pool->strings[pool->slots[slot]];
+
+			if (str->len == len && memcmp( text + str->off, text + off, len ) == 0)
+				return pool->slots[slot];
+		}
+	}
+
+	/* a new one; keep the table at most half full */
+	if (2 * (pool->num + 1) > pool->size) {
+		size = (pool->size > 0) ? 2 * pool->size : MIN_POOL_SIZE;
+		slots = (int *) malloc( size * sizeof( int ) );
+
+		if (slots == NULL)
+			return -1;
+
+		free( pool->slots );
+		pool->slots = slots;
+		pool->size = size;
+		memset( pool->slots, 0xff, size * sizeof( int ) );
+
+		for (sym = 0; sym < pool->num; sym++)
+			pool_insert( net, sym );
+	}
+
+	if (pool->num == pool->cap) {
+		str = (struct str_view *) realloc( pool->strings, (pool->size / 2) * sizeof( struct str_view ) );
+
+		if (str == NULL)
+			return -1;
+
+		pool->strings = str;
+		pool->cap = pool->size / 2;
+	}
+
+	sym = pool->num++;
+	pool->strings[sym].off = off;
+	pool->strings[sym].len = len;
+	pool_insert( net, sym );
+
+	return sym;
+}
+
+void init_network( struct network * net ) {
+	memset( net, 0, sizeof( struct network ) );
+}
+
+static int grow( void ** column, size_t elem_size, int new_cap ) {
+	void * p;
+
+	p = realloc( *column, elem_size * new_cap );
+
+	if (p == NULL)
+		return -1;
+
+	*column = p;
+	return 0;
+}
+
+/* Bitsets get their new words cleared, so records start with all flags off.
+*/
+static int grow_bits( unsigned int ** bits, int old_cap, int new_cap ) {
+	if (grow( (void **) bits, sizeof( unsigned int ), BIT_WORDS( new_cap ) ) != 0)
+		return -1;
+
+	memset( *bits + BIT_WORDS( old_cap ), 0, (BIT_WORDS( new_cap ) - BIT_WORDS( old_cap )) * sizeof( unsigned int ) );
+	return 0;
+}
+
+/* Make room for at least 'num' nodes.
+*/
+static int reserve_nodes( struct network * net, int num ) {
+	int cap;
+
+	if (num > net->node_cap) {
+		for (cap = (net->node_cap > 0) ? 2 * net->node_cap : MIN_CAPACITY; cap < num; cap *= 2)
+			;
+
+		if (grow( (void **) &net->node_id, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->node_shared_name, sizeof( struct str_view ), cap ) != 0 ||
+		    grow( (void **) &net->node_name, sizeof( struct str_view ), cap ) != 0 ||
+		    grow( (void **) &net->node_Layer, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->node_FoldChange, sizeof( double ), cap ) != 0 ||
+		    grow( (void **) &net->node_SUID, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->node_Prize, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->node_x, sizeof( double ), cap ) != 0 ||
+		    grow( (void **) &net->node_y, sizeof( double ), cap ) != 0 ||
+		    grow_bits( &net->node_isExcludedFromPaths, net->node_cap, cap ) != 0 ||
+		    grow_bits( &net->node_isInPath, net->node_cap, cap ) != 0 ||
+		    grow_bits( &net->node_selected, net->node_cap, cap ) != 0)
+			return -1;
+
+		net->node_cap = cap;
+	}
+
+	return 0;
+}
+
+/* Append a node with all attributes zeroed and return its index, or -1 if out
+   of memory.
+*/
+int add_node( struct network * net ) {
+	int i;
+
+	/* symbol 0, the empty string, is what new records start with */
+	if (net->pool.num == 0 && intern_string( net, 0, 0 ) != 0)
+		return -1;
+
+	if (reserve_nodes( net, net->num_nodes + 1 ) != 0)
+		return -1;
+
+	i = net->num_nodes++;
+
+	net->node_id[i] = 0;
+	memset( &net->node_shared_name[i], 0, sizeof( struct str_view ) );
+	memset( &net->node_name[i], 0, sizeof( struct str_view ) );
+	net->node_Layer[i] = 0;
+	net->node_FoldChange[i] = 0.0;
+	net->node_SUID[i] = 0;
+	net->node_Prize[i] = 0;
+	net->node_x[i] = 0.0;
+	net->node_y[i] = 0.0;
+
+	return i;
+}
+
+static int reserve_edges( struct network * net, int num ) {
+	int cap;
+
+	if (num > net->edge_cap) {
+		for (cap = (net->edge_cap > 0) ? 2 * net->edge_cap : MIN_CAPACITY; cap < num; cap *= 2)
+			;
+
+		if (grow( (void **) &net->edge_id, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_source, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_target, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_shared_name, sizeof( struct str_view ), cap ) != 0 ||
+		    grow( (void **) &net->edge_sh_interaction, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_name, sizeof( struct str_view ), cap ) != 0 ||
+		    grow( (void **) &net->edge_interaction, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_Time, sizeof( int ), cap ) != 0 ||
+		    grow( (void **) &net->edge_SUID, sizeof( int ), cap ) != 0 ||
+		    grow_bits( &net->edge_isInPath, net->edge_cap, cap ) != 0 ||
+		    grow_bits( &net->edge_selected, net->edge_cap, cap ) != 0)
+			return -1;
+
+		net->edge_cap = cap;
+	}
+
+	return 0;
+}
+
+/* Append an edge with all attributes zeroed and return its index, or -1 if
+   out of memory.
+*/
+int add_edge( struct network * net ) {
+	int i;
+
+	if (net->pool.num == 0 && intern_string( net, 0, 0 ) != 0)
+		return -1;
+
+	if (reserve_edges( net, net->num_edges + 1 ) != 0)
+		return -1;
+
+	i = net->num_edges++;
+
+	net->edge_id[i] = 0;
+	net->edge_source[i] = 0;
+	net->edge_target[i] = 0;
+	memset( &net->edge_shared_name[i], 0, sizeof( struct str_view ) );
+	net->edge_sh_interaction[i] = 0;
+	memset( &net->edge_name[i], 0, sizeof( struct str_view ) );
+	net->edge_interaction[i] = 0;
+	net->edge_Time[i] = 0;
+	net->edge_SUID[i] = 0;
+
+	return i;
+}
+
+static void append_bits( unsigned int * bits, int at, const unsigned int * part_bits, int num ) {
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (bit_test( part_bits, i ))
+			bit_set( bits, at + i );
+	}
+}
+
+/* Append the records of 'part', loaded from another piece of the same file,
+   after those of 'net'. Its symbols are interned again in the pool of 'net'.
+   Returns -1 if out of memory.
+*/
+int append_network( struct network * net, struct network * part ) {
+	int  * sym;
+	int    n;
+	int    e;
+	int    i;
+
+	if (net->pool.num == 0 && intern_string( net, 0, 0 ) != 0)
+		return -1;
+
+	sym = (int *) malloc( (part->pool.num + 1) * sizeof( int ) );
+
+	if (sym == NULL)
+		return -1;
+
+	for (i = 0; i < part->pool.num; i++) {
+		if ((sym[i] = intern_string( net, part->pool.strings[i].off, part->pool.strings[i].len )) < 0) {
+			free( sym );
+			return -1;
+		}
+	}
+
+	if (reserve_nodes( net, net->num_nodes + part->num_nodes ) != 0 ||
+	    reserve_edges( net, net->num_edges + part->num_edges ) != 0)
+	{
+		free( sym );
+		return -1;
+	}
+
+	/* a piece of one list has none of the other, and their columns were
+	   never allocated */
+	n = net->num_nodes;
+
+	if (part->num_nodes > 0) {
+		memcpy( net->node_id + n, part->node_id, part->num_nodes * sizeof( int ) );
+		memcpy( net->node_shared_name + n, part->node_shared_name, part->num_nodes * sizeof( struct str_view ) );
+		memcpy( net->node_name + n, part->node_name, part->num_nodes * sizeof( struct str_view ) );
+		memcpy( net->node_FoldChange + n, part->node_FoldChange, part->num_nodes * sizeof( double ) );
+		memcpy( net->node_SUID + n, part->node_SUID, part->num_nodes * sizeof( int ) );
+		memcpy( net->node_Prize + n, part->node_Prize, part->num_nodes * sizeof( int ) );
+		memcpy( net->node_x + n, part->node_x, part->num_nodes * sizeof( double ) );
+		memcpy( net->node_y + n, part->node_y, part->num_nodes * sizeof( double ) );
+
+		for (i = 0; i < part->num_nodes; i++)
+			net->node_Layer[n + i] = sym[part->node_Layer[i]];
+
+		append_bits( net->node_isExcludedFromPaths, n, part->node_isExcludedFromPaths, part->num_nodes );
+		append_bits( net->node_isInPath, n, part->node_isInPath, part->num_nodes );
+		append_bits( net->node_selected, n, part->node_selected, part->num_nodes );
+	}
+
+	e = net->num_edges;
+
+	if (part->num_edges > 0) {
+		memcpy( net->edge_id + e, part->edge_id, part->num_edges * sizeof( int ) );
+		memcpy( net->edge_source + e, part->edge_source, part->num_edges * sizeof( int ) );
+		memcpy( net->edge_target + e, part->edge_target, part->num_edges * sizeof( int ) );
+		memcpy( net->edge_shared_name + e, part->edge_shared_name, part->num_edges * sizeof( struct str_view ) );
+		memcpy( net->edge_name + e, part->edge_name, part->num_edges * sizeof( struct str_view ) );
+		memcpy( net->edge_SUID + e, part->edge_SUID, part->num_edges * sizeof( int ) );
+
+		for (i = 0; i < part->num_edges; i++) {
+			net->edge_sh_interaction[e + i] = sym[part->edge_sh_interaction[i]];
+			net->edge_interaction[e + i] = sym[part->edge_interaction[i]];
+			net->edge_Time[e + i] = sym[part->edge_Time[i]];
+		}
+
+		append_bits( net->edge_isInPath, e, part->edge_isInPath, part->num_edges );
+		append_bits( net->edge_selected, e, part->edge_selected, part->num_edges );
+	}
+
+	net->num_nodes += part->num_nodes;
+	net->num_edges += part->num_edges;
+
+	free( sym );
+	return 0;
+}
+
+/* Build the name index for the node list. If two nodes share a name the
+   last one in the file wins, same as the old search of the (reversed) node
+   list.
+*/
+static int build_node_index( struct node_index * index, struct network * net, struct arena * arena ) {
+	const struct str_view * name;
+	const struct str_view * slot_name;
+	unsigned int mask;
+	unsigned int slot;
+	int    i;
+
+	for (index->size = 16; index->size < 2 * net->num_nodes; index->size *= 2)
+		;
+
+	index->text = net->text;
+	index->names = net->node_name;
+	index->slots = (int *) arena_alloc( arena, index->size * sizeof( int ) );
+
+	if (index->slots == NULL)
+		return -1;
+
+	memset( index->slots, 0xff, index->size * sizeof( int ) );
+	mask = index->size - 1;
+
+	for (i = net->num_nodes - 1; i >= 0; i--) {
+		name = &index->names[i];
+
+		for (slot = hash_name( index->text + name->off, name->len ) & mask;
+		     index->slots[slot] >= 0;
+		     slot = (slot + 1) & mask)
+		{
+			slot_name = &index->names[index->slots[slot]];
+
+			if (slot_name->len == name->len &&
+			    memcmp( index->text + slot_name->off, index->text + name->off, name->len ) == 0)
+				break;
+		}
+
+		if (index->slots[slot] < 0)
+			index->slots[slot] = i;
+	}
+
+	return 0;
+}
+
+/* search for a node by name, returning its index or -1
+*/
+int lookup_node( struct node_index * index, const char * name ) {
+	const struct str_view * slot_name;
+	unsigned int mask;
+	unsigned int slot;
+	size_t len;
+
+	mask = index->size - 1;
+	len = strlen( name );
+
+	for (slot = hash_name( name, len ) & mask; index->slots[slot] >= 0; slot = (slot + 1) & mask) {
+		slot_name = &index->names[index->slots[slot]];
+
+		if (slot_name->len == len && memcmp( index->text + slot_name->off, name, len ) == 0)
+			return index->slots[slot];
+	}
+
+	return -1;
+}
+
+/* A set of names, copied into a buffer of its own, for the names a lazy
+   load is after (see open_network_subset()).
+*/
+void init_name_set( struct name_set * set ) {
+	memset( set, 0, sizeof( struct name_set ) );
+}
+
+void free_name_set( struct name_set * set ) {
+	free( set->text );
+	free( set->names );
+	free( set->slots );
+	init_name_set( set );
+}
+
+static void name_set_insert( struct name_set * set, int i ) {
+	const struct str_view * name = &set->names[i];
+	unsigned int mask = set->size - 1;
+	unsigned int slot;
+
+	for (slot = hash_name( set->text + name->off, name->len ) & mask; set->slots[slot] >= 0; slot = (slot + 1) & mask)
+		;
+
+	set->slots[slot] = i;
+}
+
+int has_name( const struct name_set * set, const char * name, size_t len ) {
+	const struct str_view * str;
+	unsigned int mask;
+	unsigned int slot;
+
+	if (set->size == 0)
+		return FALSE;
+
+	mask = set->size - 1;
+
+	for (slot = hash_name( name, len ) & mask; set->slots[slot] >= 0; slot = (slot + 1) & mask) {
+		str = &set->names[set->slots[slot]];
+
+		if (str->len == len && memcmp( set->text + str->off, name, len ) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Add 'name' to the set if it isn't there yet. Returns -1 if out of memory.
+*/
+int add_name( struct name_set * set, const char * name, size_t len ) {
+	size_t cap;
+	char * text;
+	int    size;
+	int    i;
+
+	if (has_name( set, name, len ))
+		return 0;
+
+	/* keep the table at most half full */
+	if (2 * (set->num + 1) > set->size) {
+		size = (set->size > 0) ? 2 * set->size : MIN_POOL_SIZE;
+
+		if (grow( (void **) &set->slots, sizeof( int ), size ) != 0 ||
+		    grow( (void **) &set->names, sizeof( struct str_view ), size / 2 ) != 0)
+			return -1;
+
+		set->size = size;
+		memset( set->slots, 0xff, size * sizeof( int ) );
+
+		for (i = 0; i < set->num; i++)
+			name_set_insert( set, i );
+	}
+
+	if (set->text_len + len > set->text_cap) {
+		for (cap = (set->text_cap > 0) ? 2 * set->text_cap : 4096; cap < set->text_len + len; cap *= 2)
+			;
+
+		if ((text = (char *) realloc( set->text, cap )) == NULL)
+			return -1;
+
+		set->text = text;
+		set->text_cap = cap;
+	}
+
+	memcpy( set->text + set->text_len, name, len );
+	set->names[set->num].off = set->text_len;
+	set->names[set->num].len = len;
+	set->text_len += len;
+	name_set_insert( set, set->num++ );
+
+	return 0;
+}
+
+struct adjacency_entry {
+	int source;
+	int target;
+	int edge;
+};
+
+static int compare_adjacency_entries( const void * a, const void * b ) {
+	const struct adjacency_entry * ea = a;
+	const struct adjacency_entry * eb = b;
+
+	if (ea->source != eb->source)
+		return (ea->source < eb->source) ? -1 : 1;
+
+	if (ea->target != eb->target)
+		return (ea->target < eb->target) ? -1 : 1;
+
+	/* later edges in the file first */
+	return (ea->edge > eb->edge) ? -1 : (ea->edge < eb->edge);
+}
+
+/* Build the CSR adjacency from the edge columns. Of parallel edges between the
+   same pair of nodes, find_edge gives the last one in the file, same as the
+   old search of the (reversed) edge list.
+*/
+static int build_edge_adjacency( struct edge_adjacency * adj, struct network * net, struct arena * arena ) {
+	struct adjacency_entry * entries;
+	int    num_edges;
+	int    i;
+	int    row;
+
+	num_edges = net->num_edges;
+	adj->num_rows = 0;
+	adj->row_source = (int *) arena_alloc( arena, (num_edges + 1) * sizeof( int ) );
+	adj->row_start = (int *) arena_alloc( arena, (num_edges + 1) * sizeof( int ) );
+	adj->col_target = (int *) arena_alloc( arena, (num_edges + 1) * sizeof( int ) );
+	adj->col_edge = (int *) arena_alloc( arena, (num_edges + 1) * sizeof( int ) );
+	/* only needed while sorting */
+	entries = (struct adjacency_entry *) malloc( (num_edges + 1) * sizeof( struct adjacency_entry ) );
+
+	if (adj->row_source == NULL || adj->row_start == NULL || adj->col_target == NULL ||
+	    adj->col_edge == NULL || entries == NULL)
+	{
+		free( entries );
+		return -1;
+	}
+
+	for (i = 0; i < num_edges; i++) {
+		entries[i].source = net->edge_source[i];
+		entries[i].target = net->edge_target[i];
+		entries[i].edge = i;
+	}
+
+	qsort( entries, num_edges, sizeof( struct adjacency_entry ), compare_adjacency_entries );
+
+	row = -1;
+
+	for (i = 0; i < num_edges; i++) {
+		if (row < 0 || adj->row_source[row] != entries[i].source) {
+			row++;
+			adj->row_source[row] = entries[i].source;
+			adj->row_start[row] = i;
+		}
+
+		adj->col_target[i] = entries[i].target;
+		adj->col_edge[i] = entries[i].edge;
+	}
+
+	adj->num_rows = row + 1;
+	adj->row_start[adj->num_rows] = num_edges;
+
+	free( entries );
+	return 0;
+}
+
+/* search for an edge by its source node id and target node id, returning its
+   index or -1
+*/
+int find_edge( struct edge_adjacency * adj, int from_id, int to_id ) {
+	int lo;
+	int hi;
+	int mid;
+	int row;
+
+	/* find the row of the source node */
+	lo = 0;
+	hi = adj->num_rows;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (adj->row_source[mid] < from_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= adj->num_rows || adj->row_source[lo] != from_id)
+		return -1;
+
+	row = lo;
+
+	/* then the first edge in that row going to the target */
+	lo = adj->row_start[row];
+	hi = adj->row_start[row + 1];
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (adj->col_target[mid] < to_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= adj->row_start[row + 1] || adj->col_target[lo] != to_id)
+		return -1;
+
+	return adj->col_edge[lo];
+}
+
+/* Load a network file and build its lookup tables, leaving the network ready
+   for post_run_py_network(). Big files are parsed with up to 'num_threads'
+   threads. An up to date snapshot of the file is used
+   instead if there is one, and one is made if there isn't. On failure the
+   reason has been added to 'report' and the network is already freed.
+*/
+int open_network( const char * file_name, struct network * net, int num_threads, struct report * report ) {
+	return open_network_subset( file_name, net, NULL, num_threads, report );
+}
+
+/* Like open_network(), but with 'wanted' only the nodes with those names,
+   and the edges between them, are loaded (see load_network()), so that one
+   run needs no more memory than its answer does. Such a network is only
+   good for the runs it was loaded for, and no snapshot is made of it; an
+   existing snapshot is still used, as it costs next to nothing to open.
+*/
+int open_network_subset( const char * file_name, struct network * net, const struct name_set * wanted,
+                         int num_threads, struct report * report )
+{
+	double start = monotonic_seconds();
+
+	if (load_snapshot( file_name, net ) == 0) {
+		printf( "post_run_py: loaded '%s' from its snapshot; num_nodes=%d num_edges=%d\n", file_name, net->num_nodes, net->num_edges );
+		net->load_seconds = monotonic_seconds() - start;
+		net->load_bytes = net->snapshot.size;
+		return 0;
+	}
+
+	if (load_network( file_name, net, wanted, num_threads, report ) != 0) {
+		free_network( net );
+		return -1;
+	}
+
+	printf( "post_run_py: loaded '%s'%s; num_nodes=%d num_edges=%d\n", file_name,
+	        (wanted != NULL) ? " for the names wanted" : "", net->num_nodes, net->num_edges );
+
+	if (build_node_index( &net->index, net, &net->arena ) != 0 ||
+	    build_edge_adjacency( &net->adj, net, &net->arena ) != 0)
+	{
+		printf( "could not allocate the network lookup tables\n" );
+		write_out_message( report, "Unable to read the network file (out of memory)." );
+		free_network( net );
+		return -1;
+	}
+
+	if (wanted == NULL && save_snapshot( file_name, net ) != 0)
+		printf( "post_run_py: could not write a snapshot of '%s'\n", file_name );
+
+	net->load_seconds = monotonic_seconds() - start;
+	net->load_bytes = net->file.size;
+	return 0;
+}
+
+void free_network( struct network * net ) {
+	/* the columns of a network opened from a snapshot are in its mapping */
+	if (net->snapshot.data != NULL) {
+		unmap_file( &net->snapshot );
+		init_network( net );
+		return;
+	}
+
+	free( net->node_id );
+	free( net->node_shared_name );
+	free( net->node_name );
+	free( net->node_Layer );
+	free( net->node_FoldChange );
+	free( net->node_SUID );
+	free( net->node_Prize );
+	free( net->node_x );
+	free( net->node_y );
+	free( net->node_isExcludedFromPaths );
+	free( net->node_isInPath );
+	free( net->node_selected );
+
+	free( net->edge_id );
+	free( net->edge_source );
+	free( net->edge_target );
+	free( net->edge_shared_name );
+	free( net->edge_sh_interaction );
+	free( net->edge_name );
+	free( net->edge_interaction );
+	free( net->edge_Time );
+	free( net->edge_SUID );
+	free( net->edge_isInPath );
+	free( net->edge_selected );
+
+	free( net->pool.strings );
+	free( net->pool.slots );
+
+	arena_release( &net->arena );
+
+	unmap_file( &net->file );
+	init_network( net );
+}
@@ -0,0 +1,297 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "post_run_py.h"
+
+/* path_list.c
+
+   The detected paths of a run, stored flat. The hops of all the paths are in
+   one array of node indexes, and each path is a range of it, so a path of
+   any length costs four bytes a hop (and four more for its hop pair)
+   however long its names are. The arrays grow by doubling, and are freed
+   with the run.
+
+   The k shortest paths share most of their hops, so each distinct pair of
+   a node and the next one on a path is kept once, in a hash table, and a
+   hop refers to its pair. The edge of a pair is then looked up and flagged
+   once however many paths go through it. Names that aren't in the network
+   are kept once each too, in a table of their own.
+*/
+
+void init_path_list( struct path_list * paths ) {
+	memset( paths, 0, sizeof( struct path_list ) );
+}
+
+void free_path_list( struct path_list * paths ) {
+	int    i;
+
+	for (i = 0; i < paths->num_missing; i++)
+		free( paths->missing[i] );
+
+	free( paths->path_start );
+	free( paths->rank );
+	free( paths->cost );
+	free( paths->pairs_before );
+	free( paths->missing_before );
+	free( paths->hop_node );
+	free( paths->hop_pair );
+	free( paths->pair_from );
+	free( paths->pair_to );
+	free( paths->pair_edge );
+	free( paths->pair_table );
+	free( paths->missing );
+	free( paths->missing_table );
+
+	init_path_list( paths );
+}
+
+static int grow_array( void ** array, size_t elem_size, long cap ) {
+	void * grown = realloc( *array, cap * elem_size );
+
+	if (grown == NULL)
+		return -1;
+
+	*array = grown;
+	return 0;
+}
+
+/* Start a new path, after the last one. Returns -1 if out of memory.
+*/
+int begin_path( struct path_list * paths, int rank, double cost ) {
+	int    cap;
+
+	if (paths->num_paths + 1 >= paths->path_cap) {
+		cap = (paths->path_cap > 0) ? paths->path_cap * 2 : 1024;
+
+		if (grow_array( (void **) &paths->path_start, sizeof( long ), cap ) != 0 ||
+		    grow_array( (void **) &paths->rank, sizeof( int ), cap ) != 0 ||
+		    grow_array( (void **) &paths->cost, sizeof( double ), cap ) != 0 ||
+		    grow_array( (void **) &paths->pairs_before, sizeof( int ), cap ) != 0 ||
+		    grow_array( (void **) &paths->missing_before, sizeof( int ), cap ) != 0)
+			return -1;
+
+		paths->path_cap = cap;
+	}
+
+	paths->path_start[paths->num_paths] = paths->num_hops;
+	paths->rank[paths->num_paths] = rank;
+	paths->cost[paths->num_paths] = cost;
+	paths->pairs_before[paths->num_paths] = paths->num_pairs;
+	paths->missing_before[paths->num_paths] = paths->num_missing;
+	paths->num_paths++;
+	paths->path_start[paths->num_paths] = paths->num_hops;
+
+	return 0;
+}
+
+static unsigned int hash_pair( int from, int to ) {
+	unsigned int h = (unsigned int) from * 0x9e3779b1u ^ (unsigned int) to * 0x85ebca6bu;
+
+	return h ^ (h >> 15);
+}
+
+/* Put the pairs kept in the pair table again, from scratch. */
+static void rehash_pairs( struct path_list * paths ) {
+	unsigned int mask = paths->table_size - 1;
+	unsigned int slot;
+	int    i;
+
+	for (i = 0; i < paths->table_size; i++)
+		paths->pair_table[i] = -1;
+
+	for (i = 0; i < paths->num_pairs; i++) {
+		for (slot = hash_pair( paths->pair_from[i], paths->pair_to[i] ) & mask;
+		     paths->pair_table[slot] >= 0; slot = (slot + 1) & mask)
+			;
+
+		paths->pair_table[slot] = i;
+	}
+}
+
+/* The pair of 'from' followed by 'to', kept the first time it is seen.
+   Returns -1 if out of memory.
+*/
+static int intern_pair( struct path_list * paths, int from, int to ) {
+	unsigned int mask;
+	unsigned int slot;
+	int    pair;
+	int    cap;
+
+	/* at most half full */
+	if (2 * (paths->num_pairs + 1) > paths->table_size) {
+		cap = (paths->table_size > 0) ? paths->table_size * 2 : 8192;
+
+		if (grow_array( (void **) &paths->pair_table, sizeof( int ), cap ) != 0)
+			return -1;
+
+		paths->table_size = cap;
+		rehash_pairs( paths );
+	}
+
+	mask = paths->table_size - 1;
+
+	for (slot = hash_pair( from, to ) & mask; (pair = paths->pair_table[slot]) >= 0; slot = (slot + 1) & mask)
+		if (paths->pair_from[pair] == from && paths->pair_to[pair] == to)
+			return pair;
+
+	if (paths->num_pairs >= paths->pair_cap) {
+		cap = (paths->pair_cap > 0) ? paths->pair_cap * 2 : 4096;
+
+		if (grow_array( (void **) &paths->pair_from, sizeof( int ), cap ) != 0 ||
+		    grow_array( (void **) &paths->pair_to, sizeof( int ), cap ) != 0 ||
+		    grow_array( (void **) &paths->pair_edge, sizeof( int ), cap ) != 0)
+			return -1;
+
+		paths->pair_cap = cap;
+	}
+
+	pair = paths->num_pairs++;
+	paths->pair_from[pair] = from;
+	paths->pair_to[pair] = to;
+	paths->pair_edge[pair] = -1;
+	paths->pair_table[slot] = pair;
+
+	return pair;
+}
+
+/* Add a hop at 'node' to the last path, which makes the pair of the hop
+   before it if both are in the network. The pair's edge is found when the
+   paths are flagged. Returns -1 if out of memory.
+*/
+int add_hop( struct path_list * paths, int node ) {
+	long   cap;
+	long   prev;
+	int    pair;
+
+	if (paths->num_hops >= paths->hop_cap) {
+		cap = (paths->hop_cap > 0) ? paths->hop_cap * 2 : 4096;
+
+		if (grow_array( (void **) &paths->hop_node, sizeof( int ), cap ) != 0 ||
+		    grow_array( (void **) &paths->hop_pair, sizeof( int ), cap ) != 0)
+			return -1;
+
+		paths->hop_cap = cap;
+	}
+
+	prev = paths->num_hops - 1;
+
+	if (prev >= paths->path_start[paths->num_paths - 1] && paths->hop_node[prev] >= 0 && node >= 0) {
+		if ((pair = intern_pair( paths, paths->hop_node[prev], node )) < 0)
+			return -1;
+
+		paths->hop_pair[prev] = pair;
+	}
+
+	paths->hop_node[paths->num_hops] = node;
+	paths->hop_pair[paths->num_hops] = -1;
+	paths->num_hops++;
+	paths->path_start[paths->num_paths] = paths->num_hops;
+
+	return 0;
+}
+
+/* Put the missing names kept in the missing table again, from scratch. */
+static void rehash_missing( struct path_list * paths ) {
+	unsigned int mask = paths->missing_table_size - 1;
+	unsigned int slot;
+	int    i;
+
+	for (i = 0; i < paths->missing_table_size; i++)
+		paths->missing_table[i] = -1;
+
+	for (i = 0; i < paths->num_missing; i++) {
+		for (slot = hash_name( paths->missing[i], strlen( paths->missing[i] ) ) & mask;
+		     paths->missing_table[slot] >= 0; slot = (slot + 1) & mask)
+			;
+
+		paths->missing_table[slot] = i;
+	}
+}
+
+/* The node of a hop whose 'name' isn't in the network: the name is kept the
+   first time it is seen, and the node is -1 - its index in 'missing'.
+   Returns 0 if out of memory, which no node is.
+*/
+int missing_node( struct path_list * paths, const char * name, size_t len ) {
+	unsigned int mask;
+	unsigned int slot;
+	char * copy;
+	int    i;
+	int    cap;
+
+	/* at most half full */
+	if (2 * (paths->num_missing + 1) > paths->missing_table_size) {
+		cap = (paths->missing_table_size > 0) ? paths->missing_table_size * 2 : 64;
+
+		if (grow_array( (void **) &paths->missing_table, sizeof( int ), cap ) != 0)
+			return 0;
+
+		paths->missing_table_size = cap;
+		rehash_missing( paths );
+	}
+
+	mask = paths->missing_table_size - 1;
+
+	for (slot = hash_name( name, len ) & mask; (i = paths->missing_table[slot]) >= 0; slot = (slot + 1) & mask)
+		if (strncmp( paths->missing[i], name, len ) == 0 && paths->missing[i][len] == '\0')
+			return -1 - i;
+
+	if (paths->num_missing >= paths->missing_cap) {
+		cap = (paths->missing_cap > 0) ? paths->missing_cap * 2 : 16;
+
+		if (grow_array( (void **) &paths->missing, sizeof( char * ), cap ) != 0)
+			return 0;
+
+		paths->missing_cap = cap;
+	}
+
+	copy = (char *) malloc( len + 1 );
+
+	if (copy == NULL)
+		return 0;
+
+	memcpy( copy, name, len );
+	copy[len] = '\0';
+	paths->missing[paths->num_missing] = copy;
+	paths->missing_table[slot] = paths->num_missing;
+
+	return -1 - paths->num_missing++;
+}
+
+/* Throw away the paths from 'first' on, and the pairs and missing names
+   only they made. */
+void truncate_paths( struct path_list * paths, int first ) {
+	if (first >= paths->num_paths)
+		return;
+
+	paths->num_hops = paths->path_start[first];
+
+	if (paths->pairs_before[first] < paths->num_pairs) {
+		paths->num_pairs = paths->pairs_before[first];
+		rehash_pairs( paths );
+	}
+
+	if (paths->missing_before[first] < paths->num_missing) {
+		while (paths->num_missing > paths->missing_before[first])
+			free( paths->missing[--paths->num_missing] );
+
+		rehash_missing( paths );
+	}
+
+	paths->num_paths = first;
+}
+
+/* The name of a hop's node, as in the network or the paths file.
+*/
+const char * hop_name( const struct network * net, const struct path_list * paths, int node, size_t * len ) {
+	const char * name;
+
+	if (node >= 0) {
+		*len = net->node_name[node].len;
+		return net->text + net->node_name[node].off;
+	}
+
+	name = paths->missing[-1 - node];
+	*len = strlen( name );
+	return name;
+}
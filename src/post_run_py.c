@@ -3,12 +3,12 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
-#include <R.h>
-#include <Rinternals.h>
-//#include <Rdefines.h>
-
-#define CHARPT(x,i)	((char*)CHAR(STRING_ELT(x,i)))
+#include "post_run_py.h"
 
 /* post_run_py.c
 
@@ -22,7 +22,9 @@
 	  exist on the network. Those not found are written out to 'run_py_out.txt',
 	  along with a tally of source and target nodes that were found.
    
-   3. Loads the 'run.py'-generated list of the detected source to target paths.
+   3. Loads the 'run.py'-generated list of the detected source to target paths,
+      or given k instead of the paths file, finds the k shortest paths itself
+      (see ksp.c), with no 'run.py' round trip at all.
    
    4. Marks each node and edge that are on one of the detected paths.
    
@@ -34,111 +36,260 @@
    report on the paths is placed in 'run_py_out.txt', and the new network in
    'run_py_out.cyjs'.
    
+   All the state of a run lives in its struct run, and the files it reads and
+   writes are given by its struct run_files, so several runs can go on at the
+   same time in one process. Output files are written under a temporary name
+   and renamed into place, so nobody ever reads a half written one.
 */
 
-#define  TRUE                     (1)
-#define  FALSE                    (0)
-
-#define  MAX_LINE_LEN             (4096)
-
-#define  IS_NONE                  (0)
-#define  IS_NODES                 (1)
-#define  IS_EDGES                 (2)
-
-struct node_record {
-	int id;
-	char shared_name[48];
-	int isExcludedFromPaths;
-	char name[48];
-	int isInPath;
-	double FoldChange;
-	int SUID;
-	char Layer[48];
-	int Prize;
-	int selected;
-	double x;
-	double y;
-	int output;
-    struct node_record * next;
-};
-
-struct edge_record {
-	int id;
-	int source;
-	int target;
-	char shared_name[48];
-	char sh_interaction[48];
-	char name[48];
-	char interaction[48];
-    int isInPath;
-	int SUID;
-	char Time[48];
-	int selected;
-	int output;
-    struct edge_record * next;
-};
-
-struct out_path {
-    int id;
-	char node_name[16];
-	struct out_path * next_in_path;
-	struct out_path * next_path;
-};
-
-/* Yep, I used a couple of global variables, sue me. This is a simple program,
-   not a giant group project. */
-int num_source;
-int num_target;
+/* How often a paths file that is being followed is looked at again. */
+#define  FOLLOW_POLL_NS           (50 * 1000 * 1000)
+/* How long a followed paths file may go without growing before it is taken
+   as complete. 'run.py' writes its paths file in one go at the end, so a
+   short pause is enough; a writer that pauses for longer makes a '.done'
+   file or writes to a pipe instead. */
+#define  FOLLOW_IDLE_SECONDS      (2.0)
 
 void print_usage( void ) {
-	printf( "Usage: post_run_py <k> <Cytoscape .js file>\n\n" );
-	printf( "where <k> is the user-specified limit on the number of paths\n" );
-	printf( "to report (shortest paths are reported first) and the Cytoscape\n" );
-	printf( ".js file contains the network information.\n" );
+	printf( "Usage: post_run_py [-f] [-l] <paths file> <Cytoscape .js file> [<in.txt> <out .cyjs> <out .txt> [<metrics file>]]\n" );
+	printf( "       post_run_py -k <k> <Cytoscape .js file> [<in.txt> <out .cyjs> <out .txt> [<metrics file>]]\n\n" );
+	printf( "where the paths file is the one written by 'run.py', or with -k, <k> is the\n" );
+	printf( "user-specified limit on the number of paths to report (shortest paths are\n" );
+	printf( "reported first), which are then found here instead, and the Cytoscape .js\n" );
+	printf( "file contains the network information. The source and target\n" );
+	printf( "file and the output files default to 'in.txt', 'run_py_out.cyjs' and\n" );
+	printf( "'run_py_out.txt'. The timings and counts of the run's phases are\n" );
+	printf( "appended to the metrics file, if given, as a line of JSON.\n" );
+	printf( "With -f the paths file (or a pipe) is followed while 'run.py' writes it, until\n" );
+	printf( "the pipe is closed, a '<paths file>.done' file is made, or it hasn't grown\n" );
+	printf( "for %g s. The paths file doesn't need to be there yet.\n", FOLLOW_IDLE_SECONDS );
+	printf( "With -l only the nodes named in the source and target file and the paths file,\n" );
+	printf( "and the edges between them, are loaded from the network (not with -f or -k).\n" );
+}
+
+const char * const phase_names[NUM_PHASES] = { "load", "in_txt", "paths", "flag", "write", "report" };
+
+double monotonic_seconds( void ) {
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Make room for 'len' more bytes in the report. */
+static int grow_report( struct report * report, size_t len ) {
+	size_t cap;
+	char * buf;
+
+	if (report->len + len > report->cap) {
+		for (cap = (report->cap > 0) ? report->cap : 4096; cap < report->len + len; cap *= 2)
+			;
+
+		buf = (char *) realloc( report->buf, cap );
+
+		if (buf == NULL) {
+			printf( "could not grow the report buffer.\n" );
+			return -1;
+		}
+
+		report->buf = buf;
+		report->cap = cap;
+	}
+
+	return 0;
 }
 
 /* Add a line to the text output. Note that it is always appended; the
    program relies on another program to remove the previous 'run_py_out.txt'
-   file.
+   file. Nothing is written until flush_out_messages() is called.
 */
-int write_out_message( char * message ) {
-    FILE * out_file;
+int write_out_message( struct report * report, char * message ) {
+	size_t len;
 
-	out_file = fopen( "run_py_out.txt", "a" );
-	
-	if (out_file == NULL) {
-		printf( "could not open \"run_py_out.txt\".\n" );
+	len = strlen( message );
+
+	/* kept for callers that don't write the report, see last_out_message() */
+	snprintf( report->last, sizeof( report->last ), "%s", message );
+
+	if (grow_report( report, len + 1 ) != 0)
+		return -1;
+
+	memcpy( report->buf + report->len, message, len );
+	report->buf[report->len + len] = '\n';
+	report->len += len + 1;
+
+	return 0;
+}
+
+const char * last_out_message( const struct report * report ) {
+	return report->last;
+}
+
+/* Create a new file to write 'file_name' under, until it is complete and
+   renamed into place. Its name, put in 'tmp_name', is made unique for every
+   process and every call, so runs going on at the same time never write
+   into each other's files. Returns the open file descriptor, or -1.
+*/
+int create_temp_file( const char * file_name, char * tmp_name, size_t size ) {
+	static unsigned long serial;
+
+	if (snprintf( tmp_name, size, "%s.%ld.%lu.tmp", file_name, (long) getpid(),
+	              __sync_add_and_fetch( &serial, 1 ) ) >= (int) size)
 		return -1;
+
+	return open( tmp_name, O_WRONLY | O_CREAT | O_EXCL, 0666 );
+}
+
+/* Open 'file_name' to be written anew. Normally that is a temporary file
+   from create_temp_file(), but something that exists and isn't a regular
+   file, like a pipe or /dev/stdout, can't be replaced and is opened to be
+   written directly, with 'tmp_name' left empty. Either way the file is done
+   with by finish_output().
+*/
+int open_output( const char * file_name, char * tmp_name, size_t size ) {
+	struct stat st;
+
+	if (stat( file_name, &st ) == 0 && !S_ISREG( st.st_mode )) {
+		tmp_name[0] = '\0';
+		return open( file_name, O_WRONLY | O_APPEND );
 	}
-	
-	fprintf( out_file, "%s\n", message );
-	
-	fclose( out_file );
+
+	return create_temp_file( file_name, tmp_name, size );
+}
+
+/* Close a file from open_output(), and if 'ok' rename it into place, or else
+   throw it away. Returns 0 if the output is in place.
+*/
+int finish_output( int fd, const char * file_name, const char * tmp_name, int ok ) {
+	if (close( fd ) != 0)
+		ok = FALSE;
+
+	if (tmp_name[0] == '\0')
+		return ok ? 0 : -1;
+
+	if (ok && rename( tmp_name, file_name ) == 0)
+		return 0;
+
+	unlink( tmp_name );
+	return -1;
+}
+
+static int write_all( struct report * report, int fd, const char * buf, size_t len ) {
+	ssize_t n;
+
+	while (len > 0) {
+		n = write( fd, buf, len );
+		report->syscalls += 1;
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return -1;
+		}
+
+		buf += n;
+		len -= n;
+		report->bytes_written += n;
+	}
+
 	return 0;
 }
 
+/* Append everything collected so far to the report file ('run_py_out.txt'
+   normally). The old report, if any, is copied into a new file that gets the
+   new lines with as few writes as the kernel allows, and which then replaces
+   the old one. Only the first 'keep' bytes of it are copied if 'keep' isn't
+   negative, so that the lines after them are written over. A report that
+   isn't a regular file just gets the new lines.
+*/
+int flush_out_messages( struct report * report, const char * report_file_name ) {
+	char   tmp_name[MAX_LINE_LEN + 64];
+	char   buf[65536];
+	ssize_t n;
+	long   left;
+	long   copied;
+	int    old;
+	int    fd;
+	int    ret;
+
+	if (report->len == 0)
+		return 0;
+
+	fd = open_output( report_file_name, tmp_name, sizeof( tmp_name ) );
+	report->syscalls += 2;
+
+	if (fd < 0) {
+		printf( "could not open \"%s\".\n", report_file_name );
+		return -1;
+	}
+
+	ret = 0;
+	old = (tmp_name[0] != '\0') ? open( report_file_name, O_RDONLY ) : -1;
+	report->syscalls += 1;
+	left = report->keep;
+	copied = 0;
+
+	if (old >= 0) {
+		while (ret == 0 && left != 0 &&
+		       (n = read( old, buf, (left > 0 && left < (long) sizeof( buf )) ? (size_t) left : sizeof( buf ) )) != 0)
+		{
+			report->syscalls += 1;
+
+			if (n < 0 && errno != EINTR)
+				ret = -1;
+			else if (n > 0) {
+				ret = write_all( report, fd, buf, n );
+				copied += n;
+
+				if (left > 0)
+					left -= n;
+			}
+		}
+
+		close( old );
+		report->syscalls += 2;
+	}
+
+	if (ret == 0)
+		ret = write_all( report, fd, report->buf, report->len );
+
+	report->start = (tmp_name[0] != '\0') ? copied : -1;
+
+	ret = finish_output( fd, report_file_name, tmp_name, ret == 0 );
+	report->syscalls += 2;
+
+	if (ret != 0)
+		printf( "could not write \"%s\".\n", report_file_name );
+
+	report->len = 0;
+
+	return ret;
+}
+
 /* The 'in.txt' file is read purely for error checking. Which nodes did
    the user specify incorrectly? How many source and target nodes were
-   specified correctly? Report this in the 'run_py_out.txt' file.
+   specified correctly? Report this in the 'run_py_out.txt' file. The nodes
+   found are flagged as sources and targets, for find_shortest_paths().
 */
-int process_in_nodes( struct node_record * head_all_nodes ) {
+int process_in_nodes( struct run * run, const char * in_file_name ) {
 	FILE * in_txt;
 	char line[MAX_LINE_LEN+1];
 	char node_name[400];
 	char node_role[400];
     int line_num;
-	struct node_record * cur_node;
+	int node;
 	
-	in_txt = fopen( "in.txt", "r" );
+	in_txt = fopen( in_file_name, "r" );
 	
 	if (in_txt == NULL) {
-		printf( "unable to open 'in.txt'\n" );
-		write_out_message( "Unable to open 'in.txt', please report this." );
+		printf( "unable to open '%s'\n", in_file_name );
+		write_out_message( &run->report, "Unable to open 'in.txt', please report this." );
 		return 1;
 	}
 
-	num_source = 0;
-	num_target = 0;
+	run->num_source = 0;
+	run->num_target = 0;
 
 	for (line_num = 1; fgets( line, sizeof(line), in_txt ) != NULL; line_num++) {
 		if (line[0] == '#')
@@ -146,273 +297,504 @@ int process_in_nodes( struct node_record * head_all_nodes ) {
 			continue;
 			
 		if (sscanf( line, "%s %s", node_name, node_role ) != 2) {
-    		printf( "bad line %d 'in.txt': %s", line_num, line );
-	    	write_out_message( "Unable to read 'in.txt', please report this." );
+    		printf( "bad line %d '%s': %s", line_num, in_file_name, line );
+	    	write_out_message( &run->report, "Unable to read 'in.txt', please report this." );
+			fclose( in_txt );
 		    return 1;
     	}
 		
-        for (cur_node = head_all_nodes; cur_node != NULL; cur_node = cur_node->next) {
-			if (strcmp( cur_node->name, node_name ) == 0)
-				break;
-		}
-		
-		if (cur_node == NULL) {
+		if ((node = lookup_node( &run->net->index, node_name )) < 0) {
+			run->metrics.names_missing += 1;
 			sprintf( line, "Node %s was not found in the network.", node_name );
-			write_out_message( line );
+			write_out_message( &run->report, line );
 		}
 		else {
-			if (strncmp( node_role, "source", 6 ) == 0)
-				num_source += 1;
-			else
-			    num_target += 1;
+			if (strncmp( node_role, "source", 6 ) == 0) {
+				run->num_source += 1;
+				bit_set( run->node_source, node );
+			}
+			else {
+			    run->num_target += 1;
+				bit_set( run->node_target, node );
+			}
         }
 			   	   
 		line_num += 1;
 	}
 	
+	fclose( in_txt );
+
+	run->metrics.names_resolved = run->num_source + run->num_target;
+
 	sprintf( line, "%d source %s and %d target %s were specified and found.\n",
-	         num_source, (num_source != 1) ? "nodes" : "node",
-			 num_target, (num_target != 1) ? "nodes" : "node" );
-	write_out_message( line );
+	         run->num_source, (run->num_source != 1) ? "nodes" : "node",
+			 run->num_target, (run->num_target != 1) ? "nodes" : "node" );
+	write_out_message( &run->report, line );
 
 	return 0;
 }
 
 /* The format of a path: A|B|C|etc where each letter represents a node name.
-   This function extracts them one at a time and advances the string pointer.
+   This function ends the name at the start of 'node_str' where it ends, and
+   returns where the next one starts, or NULL after the last one.
 */
-int chomp_node_name( char * node_str, int start_idx, char * node_name ) {
+char * chomp_node_name( char * node_str ) {
 	int i;
 	
-	for (i = 0; node_str[i] != '\0' && node_str[i] != '|' && node_str[i] != '\n' && node_str[i] != '\r'; i++) {
-		if (i < 15)
-			node_name[i] = node_str[i];
+	for (i = 0; node_str[i] != '\0' && node_str[i] != '|' && node_str[i] != '\n' && node_str[i] != '\r'; i++)
+		;
+
+	if (node_str[i] == '|') {
+		node_str[i] = '\0';
+		return node_str + i + 1;
 	}
-	
-	if (i >= 16)
-		node_name[15] = '\0';
-	else
-		node_name[i] = '\0';
-		
-	if (node_str[i] == '|')
-		return start_idx + i + 1;
-	else
-		return -1;
+
+	node_str[i] = '\0';
+	return NULL;
 }
 
-/* Load 'run_py's output of interest, namely the list of one or more paths traced
-   from source nodes to target nodes.
+/* Add the path on a line of the paths file to the run, its names looked up
+   right away so only node indexes are kept. Comment lines and lines with no
+   names are skipped. Returns 0, 1 for a line that isn't a path, or -1 if
+   out of memory.
 */
-struct out_path * load_out_paths( char * paths_file_name ) {
-    FILE * out_paths;
-    char node_name[100][16];
-	char line[MAX_LINE_LEN+1];
+static int add_path_line( struct run * run, char * line ) {
+	char * name;
+	char * next_name;
+	char * end;
 	int i;
-	int line_num;
-	int idx;
-	struct out_path * cur_out_path;
-	struct out_path * head_out_path;
-	struct out_path * new_out_path;
+	int node;
+	int rank;
+	double cost;
+
+	if (line[0] == '#')
+		return 0;
+
+	/* the first two fields are the rank and the cost of the path */
+	rank = (int) strtol( line, &end, 10 );
+
+	if (end == line)
+		rank = run->paths.num_paths + 1;
+
+	i = 0;
+
+    while (!isspace(line[i])) {
+		if (line[i] == '\0') return 1;
+		
+		i++;
+	}
+
+	if (line[i] == '\0') return 1;
 	
-	out_paths = fopen( paths_file_name, "r" );
+	while (isspace(line[i])) {
+		if (line[i] == '\0') return 1;
+		
+		i++;
+	}
 	
-	if (out_paths == NULL) {
-		printf( "unable to open '%s'\n", paths_file_name );
+	if (line[i] == '\0') return 1;
+
+	cost = strtod( line + i, NULL );
+
+    while (!isspace(line[i])) {
+		if (line[i] == '\0') return 1;
 		
-		if (num_source != 0 || num_target != 0) {
-			write_out_message( "Path analysis was not completed successfully. Possibly there were" );
-			write_out_message( "no paths between the specified source(s) and target(s).\n" );
-		}
-		else
-			write_out_message( "Path analysis was not completed successfully." );
+		i++;
+	}
+
+	if (line[i] == '\0') return 1;
+	
+	while (isspace(line[i])) {
+		if (line[i] == '\0') return 1;
 
-		return NULL;
+		i++;
 	}
 	
-	head_out_path = NULL;
+	if (line[i] == '\0') return 1;
 	
-	for (line_num = 1; fgets( line, sizeof(line), out_paths ) != NULL; line_num++) {
-		if (line[0] == '#')
+	if (begin_path( &run->paths, rank, cost ) != 0)
+		return -1;
+
+	for (name = line + i; name != NULL; name = next_name) {
+		next_name = chomp_node_name( name );
+
+		if (name[0] == '\0')
 			continue;
 
-		/* not interested in the first two fields */
-		i = 0;
+		node = lookup_node( &run->net->index, name );
 
-        while (!isspace(line[i])) {
-			if (line[i] == '\0') goto bad_line;
-			
-			i++;
-		}
+		if (node < 0 && (node = missing_node( &run->paths, name, strlen( name ) )) == 0)
+			return -1;
 
-    	if (line[i] == '\0') goto bad_line;
-		
-		while (isspace(line[i])) {
-			if (line[i] == '\0') goto bad_line;
-			
-			i++;
-		}
-		
-		if (line[i] == '\0') goto bad_line;
+		if (add_hop( &run->paths, node ) != 0)
+			return -1;
+	}
 
-        while (!isspace(line[i])) {
-			if (line[i] == '\0') goto bad_line;
-			
-			i++;
-		}
+	/* a line with no names at all isn't a path */
+	if (run->paths.path_start[run->paths.num_paths - 1] == run->paths.num_hops)
+		truncate_paths( &run->paths, run->paths.num_paths - 1 );
 
-		if (line[i] == '\0') goto bad_line;
-		
-		while (isspace(line[i])) {
-			if (line[i] == '\0') goto bad_line;
+	return 0;
+}
 
-			i++;
-		}
-		
-		if (line[i] == '\0') goto bad_line;
-		
-		idx = 0;
-		
-		while (i > 0) {
-			if (idx > 99) break;
-		
-			node_name[idx][0] = '\0';
-		
-			i = chomp_node_name( line + i, i, node_name[idx] );
+/* The names a run will look up, those in 'in.txt' and on the paths of the
+   paths file, so that only their nodes need to be loaded. A file that can't
+   be read is left for the run to complain about. Returns -1 if out of memory.
+*/
+static int wanted_names( const struct run_files * files, struct name_set * wanted ) {
+	FILE * f;
+	char line[MAX_LINE_LEN+1];
+	char node_name[400];
+	char * path_line;
+	size_t line_cap;
+	char * name;
+	char * next_name;
+	int field;
+	int i;
+	int ret;
 
-			if (node_name[idx][0] != '\0')	  	  	  
-				idx++;
+	ret = 0;
+	f = fopen( files->in_txt, "r" );
+
+	if (f != NULL) {
+		while (ret == 0 && fgets( line, sizeof(line), f ) != NULL) {
+			if (line[0] != '#' && sscanf( line, "%399s", node_name ) == 1)
+				ret = add_name( wanted, node_name, strlen( node_name ) );
 		}
-		
-		if (idx == 0)
-			continue;
-			
-		cur_out_path = NULL;
 
-		while (idx > 0) {
-			idx--;
-			
-			new_out_path = (struct out_path *) malloc( sizeof( struct out_path ) );
-			
-			strcpy( new_out_path->node_name, node_name[idx] );
-			
-			new_out_path->id = -1;
-			new_out_path->next_in_path = cur_out_path;
-			new_out_path->next_path = NULL;
-			
-			cur_out_path = new_out_path;
+		fclose( f );
+	}
+
+	f = fopen( files->paths, "r" );
+
+	if (f != NULL) {
+		path_line = NULL;
+		line_cap = 0;
+
+		while (ret == 0 && getline( &path_line, &line_cap, f ) != -1) {
+			if (path_line[0] == '#')
+				continue;
+
+			/* the names come after the rank and the cost, see add_path_line() */
+			for (i = 0, field = 0; field < 2; field++) {
+				while (path_line[i] != '\0' && !isspace( (unsigned char) path_line[i] ))
+					i++;
+
+				while (isspace( (unsigned char) path_line[i] ))
+					i++;
+			}
+
+			for (name = path_line + i; name != NULL && ret == 0; name = next_name) {
+				next_name = chomp_node_name( name );
+
+				if (name[0] != '\0')
+					ret = add_name( wanted, name, strlen( name ) );
+			}
 		}
-		
-		cur_out_path->next_path = head_out_path;
-		head_out_path = cur_out_path;
+
+		free( path_line );
+		fclose( f );
+	}
+
+	return ret;
+}
+
+static void no_paths_file( struct run * run, const char * paths_file_name ) {
+	printf( "unable to open '%s'\n", paths_file_name );
+	
+	if (run->num_source != 0 || run->num_target != 0) {
+		write_out_message( &run->report, "Path analysis was not completed successfully. Possibly there were" );
+		write_out_message( &run->report, "no paths between the specified source(s) and target(s).\n" );
+	}
+	else
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
+}
+
+/* Load 'run_py's output of interest, namely the list of one or more paths traced
+   from source nodes to target nodes. Reading starts where the last call for
+   the run left off, and the paths found are added after the run's paths.
+*/
+int load_out_paths( struct run * run, const char * paths_file_name ) {
+    FILE * out_paths;
+	char * line;
+	size_t line_cap;
+	ssize_t line_len;
+	int line_num;
+	int first_path;
+	int ret;
+	long line_off;
+	long last_line_off;
+	unsigned int last_line_hash;
+	
+	out_paths = fopen( paths_file_name, "r" );
+	
+	if (out_paths == NULL) {
+		no_paths_file( run, paths_file_name );
+		return -1;
+	}
+	
+	if (fseek( out_paths, run->paths_end, SEEK_SET ) != 0) {
+		fclose( out_paths );
+		printf( "could not seek in '%s'\n", paths_file_name );
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
+		return -1;
+	}
+
+	line = NULL;
+	line_cap = 0;
+	first_path = run->paths.num_paths;
+	line_off = run->paths_end;
+	last_line_off = run->last_line_off;
+	last_line_hash = run->last_line_hash;
+	
+	for (line_num = run->paths_lines + 1; (line_len = getline( &line, &line_cap, out_paths )) >= 0; line_num++) {
+		/* remembered to tell later whether the file has only been added to */
+		last_line_off = line_off;
+		last_line_hash = hash_name( line, line_len );
+		line_off = ftell( out_paths );
+
+		if ((ret = add_path_line( run, line )) > 0)
+			goto bad_line;
+
+		if (ret < 0)
+			goto out_of_memory;
     }
 	
+	free( line );
 	fclose( out_paths );
 
-	return head_out_path;
+	run->paths_end = line_off;
+	run->paths_lines = line_num - 1;
+	run->last_line_off = last_line_off;
+	run->last_line_hash = last_line_hash;
+
+	return 0;
 
   /* goto? blasphemy! Hey, my first programming languages were Basic and Fortran,
      long before all the absolutism began. Goto statements are fine so long as
 	 they're used sparingly and intelligently.
   */	
 bad_line:
+	free( line );
 	fclose( out_paths );
+	truncate_paths( &run->paths, first_path );
 		   	   
 	printf( "bad line %d in '%s'\n", line_num, paths_file_name );
-    write_out_message( "Path analysis was not completed successfully." );
-	return NULL;
+    write_out_message( &run->report, "Path analysis was not completed successfully." );
+	return -1;
+
+out_of_memory:
+	free( line );
+	fclose( out_paths );
+	truncate_paths( &run->paths, first_path );
+
+	printf( "out of memory loading '%s'\n", paths_file_name );
+	write_out_message( &run->report, "Path analysis was not completed successfully." );
+	return -1;
 }
 
-/* Flag any node and edge that appears on a path detected by 'run_py'.
-*/
-void flag_nodes_and_edges( struct node_record * head_node,
-                           struct edge_record * head_edge,
-						   struct out_path * head_out_paths )
-{
-	struct out_path * cur_path_head;
-	struct out_path * cur_path_node;
-    struct node_record * cur_node;
-	struct edge_record * cur_edge;
+/* Whether the writer of a paths file that is being followed is done with
+   it: a '.done' file next to it is made once it has been written. */
+static int paths_file_done( const char * paths_file_name ) {
+	char   done_name[MAX_LINE_LEN + 8];
+	struct stat st;
 
-    /* walk through the nodes first */	  
-	cur_path_head = head_out_paths;
-	cur_path_node = head_out_paths;
+	snprintf( done_name, sizeof( done_name ), "%s.done", paths_file_name );
+	return stat( done_name, &st ) == 0;
+}
 
-	while (cur_path_node != NULL) {
-		cur_node = head_node;
-		
-		while (cur_node != NULL) {
+/* Wait a little before looking at a followed paths file again. Returns FALSE
+   if the caller has interrupted the run meanwhile.
+*/
+static int follow_pause( const struct run_options * options ) {
+	struct timespec pause;
 
-			if (strcmp( cur_path_node->node_name, cur_node->name ) == 0) {
-			    /* the id will be needed to test against edges */
-				cur_path_node->id = cur_node->id;
-				/* flag this node for output */
-				cur_node->output = TRUE;
-				break;
-			}
+	pause.tv_sec = 0;
+	pause.tv_nsec = FOLLOW_POLL_NS;
+	nanosleep( &pause, NULL );
+
+	return options->interrupted == NULL || !options->interrupted();
+}
 
-			cur_node = cur_node->next;
+/* Like load_out_paths(), but while the paths file is still being written,
+   so that the paths are resolved and flagged as they come rather than after
+   'run.py' is done. A pipe or FIFO is read until its writer closes it. A
+   regular file is read as it grows, from where the run left off, until a
+   '.done' file is made next to it or it hasn't grown for the idle time of
+   'options'. It doesn't have to be there yet when following starts, and is
+   waited for up to the wait time of 'options'. A last line without a
+   newline is only taken once the writer is done.
+*/
+int follow_out_paths( struct run * run, const char * paths_file_name, const struct run_options * options ) {
+	struct stat st;
+	char * buf;
+	char * grown;
+	char * line;
+	char * eol;
+	size_t len;
+	size_t cap;
+	size_t used;
+	ssize_t got;
+	double idle_since;
+	double wait_since;
+	int    fd;
+	int    stream;
+	int    done;
+	int    line_num;
+	int    first_path;
+	int    ret;
+	long   line_off;
+	long   last_line_off;
+	unsigned int last_line_hash;
+
+	wait_since = monotonic_seconds();
+
+	while ((fd = open( paths_file_name, O_RDONLY )) < 0) {
+		if (errno != ENOENT ||
+		    (options->follow_wait >= 0 && monotonic_seconds() - wait_since > options->follow_wait))
+		{
+			no_paths_file( run, paths_file_name );
+			return -1;
 		}
-	   	   
-		if (cur_path_node->next_in_path != NULL)
-			cur_path_node = cur_path_node->next_in_path;
-		else {
-			cur_path_head = cur_path_head->next_path;
-			cur_path_node = cur_path_head;
+
+		if (!follow_pause( options )) {
+			printf( "interrupted waiting for '%s'\n", paths_file_name );
+			write_out_message( &run->report, "Path analysis was interrupted." );
+			return -1;
 		}
 	}
 
-    /* now walk the edges */
-	cur_path_head = head_out_paths;
-	cur_path_node = head_out_paths;
-	
-	while (cur_path_node != NULL) {
-		if (cur_path_node->next_in_path != NULL) {	  	  
-			cur_edge = head_edge;
-			
-    		while (cur_edge != NULL) {
-				if ((cur_edge->source == cur_path_node->id &&
-				     cur_edge->target == cur_path_node->next_in_path->id))
-				{
-				    /* flag this edge for output */
-					cur_edge->output = TRUE;
-					break;
-				}
-				
-				cur_edge = cur_edge->next;
-			}
+	stream = (fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ));
+
+	if (!stream && lseek( fd, run->paths_end, SEEK_SET ) < 0) {
+		close( fd );
+		printf( "could not seek in '%s'\n", paths_file_name );
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
+		return -1;
+	}
+
+	len = 0;
+	cap = 1 << 16;
+	buf = (char *) malloc( cap );
+	done = FALSE;
+	first_path = run->paths.num_paths;
+	line_num = run->paths_lines;
+	line_off = run->paths_end;
+	last_line_off = run->last_line_off;
+	last_line_hash = run->last_line_hash;
+	idle_since = monotonic_seconds();
+
+	if (buf == NULL)
+		goto out_of_memory;
+
+	while (!done) {
+		if (len + 1 >= cap) {
+			grown = (char *) realloc( buf, cap * 2 );
+
+			if (grown == NULL)
+				goto out_of_memory;
+
+			buf = grown;
+			cap *= 2;
+		}
+
+		got = read( fd, buf + len, cap - len - 1 );
+
+		if (got < 0) {
+			if (errno == EINTR)
+				continue;
+
+			printf( "could not read '%s'\n", paths_file_name );
+			goto failed;
 		}
 
-		if (cur_path_node->next_in_path != NULL)
-			cur_path_node = cur_path_node->next_in_path;
+		if (got == 0) {
+			/* the end of a stream is the end, but a file may still grow */
+			if (stream || paths_file_done( paths_file_name )) {
+				/* with nothing written between the last read and the marker */
+				if (!stream && (got = read( fd, buf + len, cap - len - 1 )) > 0)
+					len += got;
+				else
+					done = TRUE;
+			}
+			else if (monotonic_seconds() - idle_since > options->follow_idle) {
+				printf( "'%s' hasn't grown for %g s, taking it as complete\n", paths_file_name, options->follow_idle );
+				done = TRUE;
+			}
+			else if (follow_pause( options ))
+				continue;
+			else {
+				printf( "interrupted following '%s'\n", paths_file_name );
+				goto failed;
+			}
+		}
 		else {
-			cur_path_head = cur_path_head->next_path;
-			cur_path_node = cur_path_head;
+			len += got;
+			idle_since = monotonic_seconds();
 		}
-    } 
-}
 
-/* search for a node by name
-*/
-struct node_record * find_node( struct node_record * head_node, int id ) {
-	struct node_record * cur_node;
-	
-	for (cur_node = head_node; cur_node != NULL; cur_node = cur_node->next)
-		if (cur_node->id == id)
-			return cur_node;
-	
-	return NULL;
-}
+		/* the whole lines read so far, and at the end whatever is left */
+		used = 0;
 
-/* search for an edge by its source node id and target node id
-*/
-struct edge_record * find_edge (struct edge_record * head_edge, int from_id, int to_id ) {
-	struct edge_record * cur_edge;
-	
-	for (cur_edge = head_edge; cur_edge != NULL; cur_edge = cur_edge->next)
-		if (cur_edge->source == from_id && cur_edge->target == to_id)
-			return cur_edge;
+		while (used < len) {
+			eol = memchr( buf + used, '\n', len - used );
 
-	return NULL;
+			if (eol == NULL && !done)
+				break;
+
+			line = buf + used;
+			used = (eol != NULL) ? (size_t) (eol - buf) + 1 : len;
+			line_num++;
+
+			/* remembered as load_out_paths() does */
+			last_line_off = line_off;
+			last_line_hash = hash_name( line, buf + used - line );
+			line_off += buf + used - line;
+
+			if (eol != NULL)
+				eol[0] = '\0';
+			else
+				buf[len] = '\0';
+
+			if ((ret = add_path_line( run, line )) > 0) {
+				printf( "bad line %d in '%s'\n", line_num, paths_file_name );
+				goto failed;
+			}
+
+			if (ret < 0)
+				goto out_of_memory;
+		}
+
+		memmove( buf, buf + used, len - used );
+		len -= used;
+
+		if (flag_nodes_and_edges( run, run->paths_flagged, options->num_threads ) != 0)
+			goto failed;
+	}
+
+	free( buf );
+	close( fd );
+
+	run->paths_end = line_off;
+	run->paths_lines = line_num;
+	run->last_line_off = last_line_off;
+	run->last_line_hash = last_line_hash;
+
+	return 0;
+
+out_of_memory:
+	printf( "out of memory loading '%s'\n", paths_file_name );
+
+failed:
+	free( buf );
+	close( fd );
+	truncate_paths( &run->paths, first_path );
+
+	if (run->paths_flagged > first_path)
+		run->paths_flagged = first_path;
+
+	write_out_message( &run->report, "Path analysis was not completed successfully." );
+	return -1;
 }
 
 /* just output formatting
@@ -430,770 +812,707 @@ void write_arrow( char * s, int len ) {
 
 /* Write out the detected paths in text form to 'run_py_out.txt'. The format is name of the node in the path,
    the category of its function if known, then the type of interaction with its target and the times a
-   notable change occurred.
+   notable change occurred. Only the paths from 'first_path' on are written, last path first, but the columns
+   are as wide as all of the paths need, so that a report is laid out the same however it was written.
 */
-void write_paths( struct node_record * head_node, struct edge_record * head_edge, struct out_path * head_out_path ) {
-    struct out_path * cur_out_path_head;
-	struct out_path * cur_out_path_node;
-	struct node_record * cur_node;
-	struct edge_record * cur_edge;
-    char   line[MAX_LINE_LEN+1];
+void write_paths( struct run * run, int first_path ) {
+	struct network * net = run->net;
+	struct path_list * paths = &run->paths;
+	int    path;
+	long   hop;
+	long   end_hop;
+	int    node;
+	int    edge;
+	const struct str_view * layer;
+	const struct str_view * interaction;
+	const struct str_view * when;
+    char * line;
     char   arrow[MAX_LINE_LEN+1];
-	int    top_interaction_len;
-	int    top_time_len;
+	const char * text;
+	int    len;
+	int    arrow_len;
+	size_t top_interaction_len;
+	size_t top_time_len;
+	size_t top_name_len;
+	unsigned int * used;
+	int    sym;
 
     /* determine what the longest combination (in terms of characters) of the interaction type and the time
 	   information exists for all of the nodes of all of the paths, for formatting purposes */
+	text = net->text;
 	top_interaction_len = 0;
     top_time_len = 0;
+	top_name_len = 0;
 
-	for (cur_out_path_head = head_out_path; cur_out_path_head != NULL; cur_out_path_head = cur_out_path_head->next_path) {
-		for (cur_out_path_node = cur_out_path_head; cur_out_path_node != NULL; cur_out_path_node = cur_out_path_node->next_in_path) {
-			if (cur_out_path_node->next_in_path != NULL) {
-		    	cur_edge = find_edge( head_edge, cur_out_path_node->id, cur_out_path_node->next_in_path->id );
-				
-				if (cur_edge != NULL) {
-					if (strlen( cur_edge->interaction ) > top_interaction_len)
-					    top_interaction_len = strlen( cur_edge->interaction );
-						
-					if (strlen( cur_edge->Time ) > top_time_len )
-					    top_time_len = strlen( cur_edge->Time );
-				}
-			}
+	if (first_path >= paths->num_paths)
+		return;
+
+	/* these are interned, so it's enough to note which values are used and
+	   then measure each distinct one once */
+	used = (unsigned int *) calloc( 2 * BIT_WORDS( net->pool.num ), sizeof( unsigned int ) );
+
+	if (used == NULL) {
+		printf( "could not allocate the report\n" );
+		write_out_message( &run->report, "Unable to write the path report (out of memory)." );
+		return;
+	}
+
+	for (hop = 0; hop < paths->num_hops; hop++) {
+		edge = hop_edge( paths, hop );
+		node = paths->hop_node[hop];
+
+		if (edge >= 0) {
+			bit_set( used, net->edge_interaction[edge] );
+			bit_set( used + BIT_WORDS( net->pool.num ), net->edge_Time[edge] );
 		}
+
+		if (node >= 0 && net->node_name[node].len > top_name_len)
+			top_name_len = net->node_name[node].len;
+	}
+
+	for (sym = 0; sym < net->pool.num; sym++) {
+		if (bit_test( used, sym ) && net->pool.strings[sym].len > top_interaction_len)
+		    top_interaction_len = net->pool.strings[sym].len;
+
+		if (bit_test( used + BIT_WORDS( net->pool.num ), sym ) && net->pool.strings[sym].len > top_time_len)
+		    top_time_len = net->pool.strings[sym].len;
 	}
 
+	free( used );
+
     /* have an arrow of consistent length for the whole text report (wooooo!) */
-	write_arrow( arrow, top_interaction_len + top_time_len + 2 );
+	write_arrow( arrow, (int) (top_interaction_len + top_time_len + 2) );
+	arrow_len = strlen( arrow );
+
+	/* names are as long as they come, so the line is sized to the longest */
+	line = (char *) malloc( top_name_len + MAX_NODE_STR_LEN + arrow_len + 64 );
+
+	if (line == NULL) {
+		printf( "could not allocate the report\n" );
+		write_out_message( &run->report, "Unable to write the path report (out of memory)." );
+		return;
+	}
 
     /* now write out each path in turn, node by node */	         
-	for (cur_out_path_head = head_out_path; cur_out_path_head != NULL; cur_out_path_head = cur_out_path_head->next_path) {
-		for (cur_out_path_node = cur_out_path_head; cur_out_path_node != NULL; cur_out_path_node = cur_out_path_node->next_in_path) {
-    		cur_node = find_node( head_node, cur_out_path_node->id );
+	for (path = paths->num_paths - 1; path >= first_path; path--) {
+		end_hop = paths->path_start[path + 1];
+
+		for (hop = paths->path_start[path]; hop < end_hop; hop++) {
+    		node = paths->hop_node[hop];
 	   	   	   
-			if (cur_node == NULL) {
+			if (node < 0) {
 				/* this shouldn't happen, but anyhow.. */
 				sprintf( line, "%-15s %-15s %s", "?", "?", arrow );
-				write_out_message( line );
+				write_out_message( &run->report, line );
 			}
 			else {
 				line[0] = '\0';
 			
-				if (cur_out_path_node->next_in_path != NULL) {
-			    	cur_edge = find_edge( head_edge, cur_out_path_node->id, cur_out_path_node->next_in_path->id );
-
-                    if (cur_edge != NULL) {
-                    	sprintf( line, "%-15s %-15s %s", cur_node->name, cur_node->Layer, arrow );
-						strncpy( line + 35, cur_edge->interaction, strlen( cur_edge->interaction ) );
-						line[35 + strlen( cur_edge->interaction )] = ':';
-						line[36 + strlen( cur_edge->interaction )] = ' ';
-						strncpy( line + 35 + strlen( cur_edge->interaction) + 2, cur_edge->Time, strlen( cur_edge->Time ) );
+				if (hop + 1 < end_hop) {
+			    	edge = hop_edge( paths, hop );
+
+                    if (edge >= 0) {
+						layer = &net->pool.strings[net->node_Layer[node]];
+						interaction = &net->pool.strings[net->edge_interaction[edge]];
+						when = &net->pool.strings[net->edge_Time[edge]];
+
+                    	len = sprintf( line, "%-15.*s %-15.*s %s",
+						               (int) net->node_name[node].len, text + net->node_name[node].off,
+						               (int) layer->len, text + layer->off, arrow );
+
+						/* the interaction goes over the arrow, after its first three dashes */
+						len -= arrow_len - 3;
+						memcpy( line + len, text + interaction->off, interaction->len );
+						len += interaction->len;
+						line[len] = ':';
+						line[len + 1] = ' ';
+						memcpy( line + len + 2, text + when->off, when->len );
 					}
                 }
 				
-				if (line[0] == '\0')					
-                    sprintf( line, "%-15s %-15s", cur_node->name, cur_node->Layer ); 
+				if (line[0] == '\0') {
+					layer = &net->pool.strings[net->node_Layer[node]];
+
+                    sprintf( line, "%-15.*s %-15.*s",
+					         (int) net->node_name[node].len, text + net->node_name[node].off,
+					         (int) layer->len, text + layer->off );
+				}
 				
-				write_out_message( line );
+				write_out_message( &run->report, line );
 			}
 		}
 
-		write_out_message( " " ); 
+		write_out_message( &run->report, " " ); 
 	}
+
+	free( line );
 }
 
-int post_run_py( int argc, char ** argv ) {
-    FILE * db;
-	FILE * out_cyjs;
-    int    i;
-	int    k;
-	int    line_num;
-    char   line[MAX_LINE_LEN+1];
-	int    cur_state;
-	struct node_record * cur_node;
-	struct node_record * new_node;
-	struct edge_record * cur_edge;
-	struct edge_record * new_edge;
-	struct node_record * head_node;
-	struct edge_record * head_edge;
-	struct out_path * head_out_path;
-	int    ival;
-	double dval;
-	int    need_braces_line;
-	int    num_nodes;
-	int    num_edges;
+/* Get the run's paths up to 'k' with find_shortest_paths(), or else the
+   ones in the paths file, after any the run has already.
+*/
+static int add_paths( struct run * run, const struct run_files * files, const struct run_options * options ) {
+	int    num_old = run->paths.num_paths;
+	long   old_hops = run->paths.num_hops;
+	int    old_pairs = run->paths.num_pairs;
 	int    ret;
-	
-	if (argc != 3) {
-		print_usage();
-		return -1;
+
+	if (options->ksp_paths > 0) {
+		printf( "post_run_py: finding up to %d shortest paths\n", options->ksp_paths );
+		ret = find_shortest_paths( run, options->ksp_paths );
 	}
-	
-	db = fopen( argv[2], "r" );
-	
-	if (db == NULL) {
-		printf( "could not open \"%s\".\n", argv[2] );
-		write_out_message( "Unable to open the network file." );
+	else if (options->follow) {
+		printf( "post_run_py: following detected paths in '%s'\n", files->paths );
+		ret = follow_out_paths( run, files->paths, options );
+	}
+	else {
+		printf( "post_run_py: loading detected paths from '%s'\n", files->paths );
+		ret = load_out_paths( run, files->paths );
+	}
+
+	run->metrics.paths_loaded += run->paths.num_paths - num_old;
+	run->metrics.hops_loaded += run->paths.num_hops - old_hops;
+	run->metrics.hop_pairs += run->paths.num_pairs - old_pairs;
+
+	return ret;
+}
+
+/* Keep what the report says before the paths, so that the report can be
+   written anew when the run is extended. Returns -1 if out of memory.
+*/
+static int save_report_head( struct run * run ) {
+	run->report_head_len = run->report.len;
+	run->report_head = (char *) arena_alloc( &run->arena, run->report_head_len + 1 );
+
+	if (run->report_head == NULL) {
+		printf( "could not allocate the report\n" );
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
 		return -1;
 	}
-	
-    line_num = 1;
-	cur_state = IS_NONE;
-	cur_node = NULL;
-	cur_edge = NULL;
-	num_nodes = 0;
-	num_edges = 0;
-
-	/* Load the nodes and edges of the network file. Since the set of network files won't
-	   change for this application, the header section is ignored. When a subset network
-	   file is generated, the header is just printed out as it appears in the network
-	   file, without needing to have read it.
-    */
-	for (line_num = 1; fgets( line, sizeof(line), db ) != NULL; line_num++) {
-		if (line[0] == '#')
-			continue;
 
-        i = 0;
-			
-		while (line[i] != '\0') {
-			if (!(isspace(line[i])))
-				break;
-		
-			i++; 
-		}
-		
-		if (line[i] == '\0')
-			continue;
-			
-		if (strncmp( "\"nodes\"", line + i, 7 ) == 0) {
-			cur_state = IS_NODES;
-			continue;
-		}
-		
-		if (strncmp( "\"edges\"", line + i, 7 ) == 0) {
-			cur_state = IS_EDGES;
-			continue;
-		}
-		
-		if (cur_state == IS_NONE)
-			continue;
+	memcpy( run->report_head, run->report.buf, run->report_head_len );
+	return 0;
+}
 
-		if (cur_state == IS_NODES) {			
-        	if (strncmp( "\"id\"", line + i, 4 ) == 0) {
-    			new_node = (struct node_record *) malloc( sizeof( struct node_record ) );
-			
-				if (sscanf( line + i + 8, "%d", &ival ) == 0) {
-					printf( "failed to read id on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-	   	   			return -1;
-				}
-			
-				new_node->id = ival;
-				new_node->shared_name[0] = '\0';
-				new_node->isExcludedFromPaths = FALSE;
-				new_node->name[0] = '\0';
-				new_node->isInPath = FALSE;
-				new_node->FoldChange = 0.0;
-				new_node->SUID = 0;
-				new_node->Layer[0] = '\0';
-				new_node->Prize = 0;
-				new_node->selected = FALSE;
-				new_node->output = FALSE;
-				
-				new_node->next = cur_node;
-				cur_node = new_node;
-				
-				num_nodes += 1;
-				
-				continue;
-			}
-			
-    		if (strncmp( "\"shared_name\"", line + i, 13 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-	   	   			return -1;
-				}
-				
-                for (k = 17; line[i + k] != '"'; k++) {
-					if (k - 17 >= 15)
-						break;
-				
-					cur_node->shared_name[k - 17] = line[i + k];
-				}
-				
-				cur_node->shared_name[k - 17] = '\0';
-				
-    			continue;
-			}
-			
-			if (strncmp( "\"isExcludedFromPaths\"", line + i, 21) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-	   	   			return -1;
-				}
-				
-    			if (strncmp( "false", line + i + 24, 5) == 0)
-					cur_node->isExcludedFromPaths = FALSE;
-				else if (strncmp( "true", line + i + 24, 4) == 0)
-					cur_node->isExcludedFromPaths = TRUE;
-				else {
-					printf( "value is neither true nor false: line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-	   	   			return -1;	       	    			
-				}
-				
-				continue;
-	   	   	}
-			
-    		if (strncmp( "\"name\"", line + i, 6 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 10; line[i + k] != '"'; k++) {
-					if (k - 10 >= 15)
-						break;
-				
-					cur_node->name[k - 10] = line[i + k];
-				}
-				
-				cur_node->name[k - 10] = '\0';
-				
-    			continue;
-			}
-			
-			if (strncmp( "\"isInPath\"", line + i, 10) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (strncmp( "false", line + i + 13, 5) == 0)
-					cur_node->isInPath = FALSE;
-				else if (strncmp( "true", line + i + 13, 4) == 0)
-					cur_node->isInPath = TRUE;
-				else {
-					printf( "value is neither true nor false: line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;	       	    			
-				}
-				
-				continue;
-	   	   	}
-			
-        	if (strncmp( "\"FoldChange\"", line + i, 12 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 15, "%lf", &dval ) == 0) {
-					printf( "failed to read dval on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_node->FoldChange = dval;
-				
-				continue;
-			}
-			
-        	if (strncmp( "\"SUID\"", line + i, 6 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 9, "%d", &ival ) == 0) {
-					printf( "failed to read ival on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_node->SUID = ival;
-				
-				continue;
-			}
+/* Put what the report said before the paths back in front of the lines of
+   an extension of the run, for the report to be written anew over the
+   run's old lines, or appended as a whole if they were never written.
+   Returns -1 if out of memory.
+*/
+static int restart_report( struct run * run ) {
+	struct report * report = &run->report;
 
-    		if (strncmp( "\"Layer\"", line + i, 7 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 11; line[i + k] != '"'; k++) {
-					if (k - 11 >= 15)
-						break;
-				
-					cur_node->Layer[k - 11] = line[i + k];
-				}
-				
-				cur_node->Layer[k - 11] = '\0';
-				
-    			continue;
-			}
-			
-            if (strncmp( "\"Prize\"", line + i, 7 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 10, "%d", &ival ) == 0) {
-					printf( "failed to read ival on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_node->Prize = ival;
-				
-				continue;
-			}
+	if (grow_report( report, run->report_head_len ) != 0)
+		return -1;
 
-			if (strncmp( "\"selected\"", line + i, 10) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (strncmp( "false", line + i + 13, 5) == 0)
-					cur_node->selected = FALSE;
-				else if (strncmp( "true", line + i + 13, 4) == 0)
-					cur_node->selected = TRUE;
-				else {
-					printf( "value is neither true nor false: line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;	       	    			
-				}
-				
-				continue;
-	   	   	}
-			
-            if (strncmp( "\"x\"", line + i, 3 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 6, "%lf", &dval ) == 0) {
-					printf( "failed to read dval on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_node->x = dval;
-				
-				continue;
-			}
+	memmove( report->buf + run->report_head_len, report->buf, report->len );
+	memcpy( report->buf, run->report_head, run->report_head_len );
+	report->len += run->report_head_len;
+	report->keep = run->report_start;
 
-            if (strncmp( "\"y\"", line + i, 3 ) == 0) {
-				if (cur_node == NULL) {
-					printf( "node field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 6, "%lf", &dval ) == 0) {
-					printf( "failed to read dval on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_node->y = dval;
-				
-				continue;
-			}
-			
-    	   	continue;
-        }
-		
-		if (cur_state == IS_EDGES) {			
-        	if (strncmp( "\"id\"", line + i, 4 ) == 0) {
-    			new_edge = (struct edge_record *) malloc( sizeof( struct edge_record ) );
-			
-				if (sscanf( line + i + 8, "%d", &ival ) == 0) {
-					printf( "failed to read id on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				new_edge->id = ival;
-				new_edge->source = 0;
-				new_edge->target = 0;
-				new_edge->shared_name[0] = '\0';
-				new_edge->sh_interaction[0] = '\0';
-				new_edge->name[0] = '\0';
-				new_edge->interaction[0] = '\0';
-				new_edge->isInPath = FALSE;
-				new_edge->SUID = 0;
-				new_edge->Time[0] = '\0';
-				new_edge->selected = FALSE;
-				new_edge->output = FALSE;
- 	 	 	 
-				new_edge->next = cur_edge;
-				cur_edge = new_edge;
-				
-				num_edges += 1;
-				
-				continue;
-			}
-			
-        	if (strncmp( "\"source\"", line + i, 8 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 12, "%d", &ival ) == 0) {
-					printf( "failed to read ival on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_edge->source = ival;
-				
-				continue;
-			}
+	return 0;
+}
 
-        	if (strncmp( "\"target\"", line + i, 8 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 12, "%d", &ival ) == 0) {
-					printf( "failed to read ival on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_edge->target = ival;
-				
-				continue;
-			}
+/* Start the metrics of a call that makes or extends the run. */
+static void start_metrics( struct run * run ) {
+	memset( &run->metrics, 0, sizeof( struct run_metrics ) );
+	run->metrics.seconds[PHASE_LOAD] = run->net->load_seconds;
+	run->metrics.bytes_parsed = run->net->load_bytes;
+	run->metrics.nodes_loaded = run->net->num_nodes;
+	run->metrics.edges_loaded = run->net->num_edges;
+}
 
-       	    if (strncmp( "\"shared_name\"", line + i, 13 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 17; line[i + k] != '"'; k++) {
-					if (k - 17 >= 47)
-						break;
-				
-					cur_edge->shared_name[k - 17] = line[i + k];
-				}
-				
-				cur_edge->shared_name[k - 17] = '\0';
-				
-    			continue;
-			}
-			
-       	    if (strncmp( "\"sh_interaction\"", line + i, 16 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 20; line[i + k] != '"'; k++) {
-					if (k - 20 >= 47)
-						break;
-				
-					cur_edge->sh_interaction[k - 20] = line[i + k];
-				}
-				
-				cur_edge->sh_interaction[k - 20] = '\0';
-				
-    			continue;
-			}
-			
- 	    	if (strncmp( "\"name\"", line + i, 6 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 10; line[i + k] != '"'; k++) {
-					if (k - 10 >= 47)
-						break;
-				
-					cur_edge->name[k - 10] = line[i + k];
-				}
-				
-				cur_edge->name[k - 10] = '\0';
-				
-    			continue;
-			}
-			
-       	    if (strncmp( "\"interaction\"", line + i, 13 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 17; line[i + k] != '"'; k++) {
-					if (k - 17 >= 47)
-						break;
-				
-					cur_edge->interaction[k - 17] = line[i + k];
-				}
-				
-				cur_edge->interaction[k - 17] = '\0';
-				
-    			continue;
-			}
-			
-    		if (strncmp( "\"isInPath\"", line + i, 10) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (strncmp( "false", line + i + 13, 5) == 0)
-					cur_edge->isInPath = FALSE;
-				else if (strncmp( "true", line + i + 13, 4) == 0)
-					cur_edge->isInPath = TRUE;
-				else {
-					printf( "value is neither true nor false: line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;	       	    			
-				}
-				
-				continue;
-	   	   	}
-			
-        	if (strncmp( "\"SUID\"", line + i, 6 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (sscanf( line + i + 9, "%d", &ival ) == 0) {
-					printf( "failed to read ival on line %d, line was '%s'\n", line_num, line );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-			
-				cur_edge->SUID = ival;
-				
-				continue;
-			}
+/* Add the time since 'start' to 'phase', returning the time now for the
+   start of the next phase.
+*/
+static double time_phase( struct run * run, int phase, double start ) {
+	double now = monotonic_seconds();
 
-    		if (strncmp( "\"Time\"", line + i, 6 ) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-                for (k = 10; line[i + k] != '"'; k++) {
-					if (k - 10 >= 47)
-						break;
-				
-					cur_edge->Time[k - 10] = line[i + k];
-				}
-				
-				cur_edge->Time[k - 10] = '\0';
-				
-    			continue;
-			}
-			
-			if (strncmp( "\"selected\"", line + i, 10) == 0) {
-				if (cur_edge == NULL) {
-					printf( "edge field before id? line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;
-				}
-				
-    			if (strncmp( "false", line + i + 13, 5) == 0)
-					cur_edge->selected = FALSE;
-				else if (strncmp( "true", line + i + 13, 4) == 0)
-					cur_edge->selected = TRUE;
-				else {
-					printf( "value is neither true nor false: line %d\n", line_num );
-            		write_out_message( "Unable to read the network file (bad format)." );
-    				return -1;	       	    			
-				}
-				
-				continue;
-	   	   	}
-		}
-    }
+	run->metrics.seconds[phase] += now - start;
+	return now;
+}
 
-	fclose( db );
-	
-	printf( "post_run_py: loaded '%s'; num_nodes=%d num_edges=%d\n", argv[2], num_nodes, num_edges );
-	
-	head_node = cur_node;
-	head_edge = cur_edge;
+/* Count what the run has flagged, after flagging some more. */
+static void count_flagged( struct run * run ) {
+	run->metrics.nodes_flagged = bit_count( run->node_output, run->net->num_nodes );
+	run->metrics.edges_flagged = bit_count( run->edge_output, run->net->num_edges );
+}
+
+/* Tie a new run to the network and its files and give it its flags. What is
+   allocated here, and for the rest of the run, belongs to the run's arena
+   and is freed in one go.
+*/
+int prepare_run( struct run * run, struct network * net, const struct run_files * files ) {
+	run->net = net;
+	run->files = files;
+	start_metrics( run );
+	run->node_source = (unsigned int *) arena_calloc( &run->arena, BIT_WORDS( net->num_nodes ), sizeof( unsigned int ) );
+	run->node_target = (unsigned int *) arena_calloc( &run->arena, BIT_WORDS( net->num_nodes ), sizeof( unsigned int ) );
+	run->node_output = (unsigned int *) arena_calloc( &run->arena, BIT_WORDS( net->num_nodes ), sizeof( unsigned int ) );
+	run->edge_output = (unsigned int *) arena_calloc( &run->arena, BIT_WORDS( net->num_edges ), sizeof( unsigned int ) );
+
+	if (run->node_source == NULL || run->node_target == NULL ||
+	    run->node_output == NULL || run->edge_output == NULL)
+	{
+		printf( "could not allocate the output flags\n" );
+		write_out_message( &run->report, "Path analysis was not completed successfully." );
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Check the source and target file and flag the paths of the paths file, or
+   the shortest paths found for it, on the network, leaving the results in
+   'run'. With 'write_files' set in the options the subset network and the
+   text report are written out too. The run has been set up with init_run(),
+   and whatever happens it has to be released with release_run() afterwards.
+*/
+static int process_paths( struct run * run, struct network * net, const struct run_files * files,
+                          const struct run_options * options )
+{
+	double start;
+	int    ret;
+
+	if (prepare_run( run, net, files ) != 0)
+		return -1;
 
     /* Load 'in.txt' */
-	printf( "post_run_py: loading 'in.txt'\n" );
-	if((ret=process_in_nodes( head_node )))
+	printf( "post_run_py: loading '%s'\n", files->in_txt );
+	start = monotonic_seconds();
+	ret = process_in_nodes( run, files->in_txt );
+	start = time_phase( run, PHASE_IN_TXT, start );
+	if (ret)
 		return ret;
 
     /* Load the list of detected path. The file name will depend on the limit specified
-	   for the number of paths to be recorded ('k').
+	   for the number of paths to be recorded ('k'), unless they are found here.
 	*/
-	printf( "post_run_py: loading detected paths from '%s'\n", argv[1] );
-	if(!(head_out_path = load_out_paths( argv[1] )))
+	ret = add_paths( run, files, options );
+	start = time_phase( run, PHASE_PATHS, start );
+	if (ret != 0 || run->paths.num_paths == 0)
 		return 1;
 
+	if (save_report_head( run ) != 0)
+		return -1;
+
     /* Mark the nodes and edges that are part of the paths detected by 'run.py'.*/
 	printf( "post_run_py: marking nodes and edges that are part of the detected paths\n" );
-    flag_nodes_and_edges( head_node, head_edge, head_out_path );
+	ret = flag_nodes_and_edges( run, run->paths_flagged, options->num_threads );
+	start = time_phase( run, PHASE_FLAG, start );
+	if (ret != 0)
+		return ret;
 
-    /* Write out the subset of the network for display. */ 
-	printf( "post_run_py: writing out network subset to 'run_py_out.cyjs'\n" );
-	out_cyjs = fopen( "run_py_out.cyjs", "w" );
-	
-	if (out_cyjs == NULL) {
-		printf( "could not open 'run_py_out.cyjs'\n" );
-		write_out_message( "Unable to open the sub-network file to write." );
-		return -1;
+	count_flagged( run );
+
+	if (options->write_files) {
+	    /* Write out the subset of the network for display. */ 
+		printf( "post_run_py: writing out network subset to '%s'\n", files->out_cyjs );
+		ret = write_subset_network( run, options->compact_json );
+		start = time_phase( run, PHASE_WRITE, start );
+		if (ret != 0)
+			return ret;
+
+	    /* Create a text format report of the detected paths that contains more detail
+		   than that produced by 'run.py'.
+		*/
+		printf( "post_run_py: writing text report to '%s'\n", files->out_txt );
+		write_paths( run, 0 );
+		time_phase( run, PHASE_REPORT, start );
 	}
-	
-    fprintf( out_cyjs, "{\n" );
-    fprintf( out_cyjs, "  \"format_version\" : \"1.0\",\n" );
-    fprintf( out_cyjs, "  \"generated_by\" : \"cytoscape-3.7.2\",\n" );
-    fprintf( out_cyjs, "  \"target_cytoscapejs_version\" : \"~2.1\",\n" );
-    fprintf( out_cyjs, "  \"data\" : {\n" );
-    fprintf( out_cyjs, "    \"shared_name\" : \"my_time1_all_edge.txt\",\n" );
-    fprintf( out_cyjs, "    \"name\" : \"my_time1_all_edge.txt\",\n" );
-    fprintf( out_cyjs, "    \"SUID\" : 81000,\n" );
-    fprintf( out_cyjs, "    \"__Annotations\" : [ \"\" ],\n" );
-    fprintf( out_cyjs, "    \"selected\" : true\n" );
-    fprintf( out_cyjs, "  },\n" );
-    fprintf( out_cyjs, "  \"elements\" : {\n" );
-	fprintf( out_cyjs, "    \"nodes\" : [ {\n" );
-	
-	need_braces_line = FALSE;
 
-	while (cur_node != NULL) {
-		if (cur_node->output == FALSE) {
-			cur_node = cur_node->next;
-			continue;
+    printf( "post_run_py: complete\n" );
+
+	return 0;
+}
+
+/* Put 'str' in 'buf' as a JSON string, quotes and all, as far as it fits.
+*/
+static size_t json_string( char * buf, size_t size, const char * str ) {
+	size_t len;
+
+	len = 0;
+	buf[len++] = '"';
+
+	for (; *str != '\0' && len + 8 < size; str++) {
+		if (*str == '"' || *str == '\\') {
+			buf[len++] = '\\';
+			buf[len++] = *str;
 		}
-		
-		if (need_braces_line == TRUE)
-			fprintf( out_cyjs, "    }, {\n" );
-	
-		fprintf( out_cyjs, "      \"data\" : {\n" );
-		fprintf( out_cyjs, "        \"id\" : \"%d\",\n", cur_node->id );
-		fprintf( out_cyjs, "        \"shared_name\" : \"%s\",\n", cur_node->shared_name );
-		fprintf( out_cyjs, "        \"isExcludedFromPaths\" : %s,\n",
-		         (cur_node->isExcludedFromPaths == TRUE ? "true" : "false") );
-	    fprintf( out_cyjs, "        \"name\" : \"%s\",\n", cur_node->name );
-		fprintf( out_cyjs, "        \"isInPath\" : %s,\n",
-		         (cur_node->isInPath == TRUE ? "true" : "false") );
-        fprintf( out_cyjs, "        \"FoldChange\" : %lf,\n", cur_node->FoldChange );
-		fprintf( out_cyjs, "        \"SUID\" : %d,\n", cur_node->SUID );
-		fprintf( out_cyjs, "        \"Layer\" : \"%s\",\n", cur_node->Layer );
-		fprintf( out_cyjs, "        \"Prize\" : %d,\n", cur_node->Prize );
-		fprintf( out_cyjs, "        \"selected\" : %s\n",
-     	         (cur_node->selected == TRUE ? "true" : "false"));
-	    fprintf( out_cyjs, "      },\n" );
-		fprintf( out_cyjs, "      \"position\" : {\n" );
-		fprintf( out_cyjs, "        \"x\" : %lf,\n", cur_node->x );
-		fprintf( out_cyjs, "        \"y\" : %lf\n", cur_node->y );
-		fprintf( out_cyjs, "      },\n" );
-		fprintf( out_cyjs, "      \"selected\" : %s\n",
-		        (cur_node->selected == TRUE ? "true" : "false"));
-			   
-		need_braces_line = TRUE;
-
-		cur_node = cur_node->next;
+		else if ((unsigned char) *str < 0x20)
+			len += sprintf( buf + len, "\\u%04x", (unsigned char) *str );
+		else
+			buf[len++] = *str;
 	}
 
-	fprintf( out_cyjs, "    } ],\n" );
-	fprintf( out_cyjs, "    \"edges\" : [ {\n" );
-	
-	need_braces_line = FALSE;
+	buf[len++] = '"';
+	buf[len] = '\0';
+	return len;
+}
 
-	while (cur_edge != NULL) {
-		if (cur_edge->output == FALSE) {
-			cur_edge = cur_edge->next;
-			continue;
+/* Append the metrics of a run to the metrics file as one JSON line, in a
+   single write so that the lines of runs going on at the same time don't
+   get mixed up.
+*/
+static void write_metrics( struct run * run, const struct run_files * files, const struct run_options * options, int ret ) {
+	const struct run_metrics * m = &run->metrics;
+	char   line[2 * MAX_LINE_LEN];
+	size_t len;
+	int    phase;
+	int    fd;
+
+	len = snprintf( line, sizeof( line ), "{\"time\":%ld,\"paths\":", (long) time( NULL ) );
+
+	if (options->ksp_paths > 0)
+		len += snprintf( line + len, sizeof( line ) - len, "%d", options->ksp_paths );
+	else
+		len += json_string( line + len, MAX_LINE_LEN, files->paths );
+
+	len += snprintf( line + len, sizeof( line ) - len, ",\"ok\":%s", (ret == 0) ? "true" : "false" );
+
+	for (phase = 0; phase < NUM_PHASES; phase++)
+		len += snprintf( line + len, sizeof( line ) - len, ",\"%s_s\":%.6f", phase_names[phase], m->seconds[phase] );
+
+	len += snprintf( line + len, sizeof( line ) - len,
+	                 ",\"bytes_parsed\":%ld,\"nodes_loaded\":%d,\"edges_loaded\":%d,\"names_resolved\":%d,"
+	                 "\"names_missing\":%d,\"paths_loaded\":%d,\"hops_loaded\":%ld,\"hop_pairs\":%d,"
+	                 "\"nodes_flagged\":%d,\"edges_flagged\":%d,\"bytes_written\":%ld,\"report_syscalls\":%ld}\n",
+	                 m->bytes_parsed, m->nodes_loaded, m->edges_loaded, m->names_resolved, m->names_missing,
+	                 m->paths_loaded, m->hops_loaded, m->hop_pairs, m->nodes_flagged, m->edges_flagged, m->bytes_written,
+	                 m->report_syscalls );
+
+	fd = open( options->metrics_file, O_WRONLY | O_APPEND | O_CREAT, 0666 );
+
+	if (fd < 0 || write( fd, line, len ) != (ssize_t) len)
+		printf( "could not write the metrics to '%s'\n", options->metrics_file );
+
+	if (fd >= 0)
+		close( fd );
+}
+
+/* End a call that made or extended a run: write out the report, timed with
+   the rest of the report phase, and append the metrics to the metrics file
+   if there is one.
+*/
+static int finish_run( struct run * run, int ret, const struct run_files * files, const struct run_options * options,
+                       const char * report_file_name )
+{
+	double start = monotonic_seconds();
+
+	ret = end_report( &run->report, ret, report_file_name );
+	time_phase( run, PHASE_REPORT, start );
+
+	/* where the run's lines are, once they have all been written */
+	if (report_file_name != NULL && ret == 0 && (run->report_start < 0 || run->report.keep >= 0))
+		run->report_start = run->report.start;
+	run->metrics.bytes_written += run->report.bytes_written;
+	run->metrics.report_syscalls += run->report.syscalls;
+
+	if (options->metrics_file != NULL)
+		write_metrics( run, files, options, ret );
+
+	return ret;
+}
+
+/* Whether the paths file still holds what the run has read of it, with at
+   most more lines after that. Only the last line read is compared, so that
+   checking costs nothing like reading the whole file again.
+*/
+static int paths_file_extends_run( struct run * run ) {
+	FILE * out_paths;
+	char * line;
+	size_t line_cap;
+	ssize_t line_len;
+	struct stat st;
+	int    same;
+
+	if (run->paths_end == 0)
+		return TRUE;
+
+	/* a pipe can only ever go on */
+	if (stat( run->files->paths, &st ) == 0 && !S_ISREG( st.st_mode ))
+		return TRUE;
+
+	out_paths = fopen( run->files->paths, "r" );
+
+	if (out_paths == NULL)
+		return FALSE;
+
+	line = NULL;
+	line_cap = 0;
+	same = (fseek( out_paths, run->last_line_off, SEEK_SET ) == 0 &&
+	        (line_len = getline( &line, &line_cap, out_paths )) >= 0 &&
+	        hash_name( line, line_len ) == run->last_line_hash &&
+	        ftell( out_paths ) == run->paths_end);
+
+	free( line );
+	fclose( out_paths );
+	return same;
+}
+
+/* Flag the paths that have been added to the paths file since the run was
+   made, as when PathLinker is run again with a bigger k, and rewrite the
+   subset network with them. Only the new paths are read and resolved. The
+   run's lines in the report are written anew, so the report is the same as
+   that of a run made with all the paths at once. If the file has changed in
+   any other way the run is just made again from scratch, over the old lines
+   of the report. A run whose paths are found by find_shortest_paths() is extended
+   to the 'ksp_paths' of 'options' instead, carrying on with its search.
+   The run must have been made by post_run_py_network(), with the same
+   files, and is released by the caller as usual.
+*/
+int post_run_py_extend( struct run * run, const struct run_options * options ) {
+	struct network * net = run->net;
+	const struct run_files * files = run->files;
+	double start;
+	long   report_start;
+	int    num_old;
+	int    ret;
+
+	/* a run that got no paths at all is made again too */
+	if (run->paths.num_paths == 0 ||
+	    (options->ksp_paths > 0 ? run->search == NULL : !paths_file_extends_run( run )))
+	{
+		printf( "post_run_py: starting the run over\n" );
+		report_start = run->report_start;
+		release_run( run );
+		init_run( run );
+		run->report.keep = report_start;
+
+		return finish_run( run, process_paths( run, net, files, options ), files, options,
+		                   options->write_files ? files->out_txt : NULL );
+	}
+
+	begin_report( &run->report );
+	start_metrics( run );
+	num_old = run->paths.num_paths;
+
+	start = monotonic_seconds();
+	ret = add_paths( run, files, options );
+	start = time_phase( run, PHASE_PATHS, start );
+
+	if (ret == 0 && run->paths.num_paths > num_old) {
+		printf( "post_run_py: marking %d new paths\n", run->paths.num_paths - num_old );
+		ret = flag_nodes_and_edges( run, run->paths_flagged, options->num_threads );
+		start = time_phase( run, PHASE_FLAG, start );
+
+		if (ret == 0 && options->write_files) {
+			printf( "post_run_py: writing out network subset to '%s'\n", files->out_cyjs );
+			ret = write_subset_network( run, options->compact_json );
+			start = time_phase( run, PHASE_WRITE, start );
+
+			if (ret == 0) {
+				printf( "post_run_py: writing text report to '%s'\n", files->out_txt );
+				ret = restart_report( run );
+
+				if (ret == 0)
+					write_paths( run, 0 );
+
+				time_phase( run, PHASE_REPORT, start );
+			}
 		}
-	
-		if (need_braces_line == TRUE)
-			fprintf( out_cyjs, "    }, {\n" );
-	
- 	    fprintf( out_cyjs, "      \"data\" : {\n" );
-		fprintf( out_cyjs, "        \"id\" : \"%d\",\n", cur_edge->id );
-		fprintf( out_cyjs, "        \"source\" : \"%d\",\n", cur_edge->source );
-		fprintf( out_cyjs, "        \"target\" : \"%d\",\n", cur_edge->target );
-    	fprintf( out_cyjs, "        \"shared_name\" : \"%s\",\n", cur_edge->shared_name );
-    	fprintf( out_cyjs, "        \"sh_interaction\" : \"%s\",\n", cur_edge->sh_interaction );
-	    fprintf( out_cyjs, "        \"name\" : \"%s\",\n", cur_edge->name );
-		fprintf( out_cyjs, "        \"interaction\" : \"%s\",\n", cur_edge->interaction );
-		fprintf( out_cyjs, "        \"isInPath\" : %s,\n",
-		         (cur_edge->isInPath == TRUE ? "true" : "false") );
-		fprintf( out_cyjs, "        \"SUID\" : %d,\n", cur_edge->SUID );
-		fprintf( out_cyjs, "        \"Time\" : \"%s\",\n", cur_edge->Time );
-		fprintf( out_cyjs, "        \"selected\" : %s\n",
-     	         (cur_edge->selected == TRUE ? "true" : "false"));
-	    fprintf( out_cyjs, "      },\n" );
-		fprintf( out_cyjs, "      \"selected\" : %s\n",
-		        (cur_edge->selected == TRUE ? "true" : "false"));
-
-		need_braces_line = TRUE;
-			
-		cur_edge = cur_edge->next;
 	}
-	
-	fprintf( out_cyjs, "    } ]\n" );
-    fprintf( out_cyjs, "  }\n" );
-	fprintf( out_cyjs, "}\n" );
-	
-	fflush( out_cyjs );
-	fclose( out_cyjs );
 
-    /* Create a text format report of the detected paths that contains more detail
-	   than that produced by 'run.py'.
-	*/
-	printf( "post_run_py: writing text report to 'run_py_out.txt'\n" );
-	write_paths( head_node, head_edge, head_out_path );
+	count_flagged( run );
 
-    printf( "post_run_py: complete\n" );
-	return 0;
+	return finish_run( run, ret, files, options, options->write_files ? files->out_txt : NULL );
 }
 
-SEXP R_post_run_py(SEXP R_args){
-	int i;
-	int argc=length(R_args);
-	char **argv;
-
-	argv=malloc(sizeof(*argv)*argc);
-	if(argv==NULL)
-		return NULL;
-	for(i=0;i<argc;i++){
-		argv[i]=CHARPT(R_args, i);
+/* Clear a run before anything is added to its report or its arena.
+*/
+void init_run( struct run * run ) {
+	memset( run, 0, sizeof( struct run ) );
+	begin_report( &run->report );
+	arena_init( &run->arena );
+	init_path_list( &run->paths );
+	run->report_start = -1;
+}
+
+void release_run( struct run * run ) {
+	arena_release( &run->arena );
+	free_path_list( &run->paths );
+}
+
+/* The file names and options of a run of the original program, with only
+   the paths file given.
+*/
+void default_run_files( struct run_files * files, const char * paths_file_name ) {
+	files->paths = paths_file_name;
+	files->in_txt = "in.txt";
+	files->out_cyjs = "run_py_out.cyjs";
+	files->out_txt = "run_py_out.txt";
+}
+
+void default_run_options( struct run_options * options ) {
+	options->write_files = TRUE;
+	options->num_threads = 1;
+	options->compact_json = FALSE;
+	options->ksp_paths = 0;
+	options->follow = FALSE;
+	options->follow_wait = -1.0;
+	options->follow_idle = FOLLOW_IDLE_SECONDS;
+	options->interrupted = NULL;
+	options->metrics_file = NULL;
+}
+
+/* Start an empty report, for messages that come before there is a run.
+*/
+void begin_report( struct report * report ) {
+	memset( report, 0, sizeof( struct report ) );
+	report->keep = -1;
+	report->start = -1;
+}
+
+/* Write out the text report to 'report_file_name', also when the processing
+   bailed out early with an error message for the user. Without a file name
+   it is just dropped.
+*/
+int end_report( struct report * report, int ret, const char * report_file_name ) {
+	if (report_file_name != NULL) {
+		if (flush_out_messages( report, report_file_name ) != 0 && ret == 0)
+			ret = -1;
 	}
 
-	post_run_py(argc,argv);
+	free( report->buf );
+	report->buf = NULL;
+	report->len = 0;
+	report->cap = 0;
 
-	free(argv);
+	return ret;
+}
 
-	return NULL;
+/* Run the whole post-processing, loading the network from scratch.
+*/
+int post_run_py( int argc, char ** argv ) {
+	struct network net;
+	struct run_files files;
+	struct run_options options;
+	struct run run;
+	struct name_set wanted;
+	const char * paths_file_name;
+	char * end;
+	int    lazy;
+	int    ret;
+
+	default_run_options( &options );
+	lazy = FALSE;
+
+	for (; argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0' && argv[1][2] == '\0'; argv++, argc--) {
+		if (argv[1][1] == 'f')
+			options.follow = TRUE;
+		else if (argv[1][1] == 'l')
+			lazy = TRUE;
+		else if (argv[1][1] == 'k' && argc > 2) {
+			options.ksp_paths = (int) strtol( argv[2], &end, 10 );
+
+			if (end == argv[2] || *end != '\0' || options.ksp_paths < 1) {
+				print_usage();
+				return -1;
+			}
+
+			argv++;
+			argc--;
+		}
+		else {
+			print_usage();
+			return -1;
+		}
+	}
+
+	/* with -k there is no paths file, and the network file comes first */
+	paths_file_name = NULL;
+
+	if (options.ksp_paths == 0 && argc > 1) {
+		paths_file_name = argv[1];
+		argv++;
+		argc--;
+	}
+
+	if (argc != 2 && argc != 5 && argc != 6) {
+		print_usage();
+		return -1;
+	}
+
+	default_run_files( &files, paths_file_name );
+
+	if (argc >= 5) {
+		files.in_txt = argv[2];
+		files.out_cyjs = argv[3];
+		files.out_txt = argv[4];
+	}
+
+	if (argc == 6)
+		options.metrics_file = argv[5];
+
+	init_run( &run );
+	init_name_set( &wanted );
+
+	/* found or followed paths can go anywhere in the network */
+	if (lazy && (options.ksp_paths > 0 || options.follow)) {
+		printf( "post_run_py: -l needs a finished paths file; loading all of the network\n" );
+		lazy = FALSE;
+	}
+
+	if (lazy && wanted_names( &files, &wanted ) != 0) {
+		printf( "post_run_py: out of memory collecting the names wanted; loading all of the network\n" );
+		lazy = FALSE;
+	}
+
+	ret = open_network_subset( argv[1], &net, lazy ? &wanted : NULL, options.num_threads, &run.report );
+	free_name_set( &wanted );
+
+	if (ret == 0) {
+		ret = process_paths( &run, &net, &files, &options );
+		release_run( &run );
+		free_network( &net );
+	}
+
+	/* the metrics and the report aren't in the run's arena */
+	return finish_run( &run, ret, &files, &options, files.out_txt );
+}
+
+/* Run the post-processing against a network that is already loaded, see
+   open_network(). The results are left in 'run' for the caller, who releases
+   it. Without 'write_files' nothing is written at all, and the reason for a
+   failure is only given by last_out_message() on the run's report.
+*/
+int post_run_py_network( struct run * run, struct network * net, const struct run_files * files,
+                         const struct run_options * options )
+{
+	init_run( run );
+
+	return finish_run( run, process_paths( run, net, files, options ), files, options,
+	                   options->write_files ? files->out_txt : NULL );
+}
+
+/* Run a batch of jobs against one loaded network, each with its own files,
+   so the network is only loaded and indexed once. A failed job doesn't stop
+   the others; its reason is in its own report. Every job is run with the
+   same 'options'. Returns the number of jobs that failed, and if 'status'
+   isn't NULL the result of each job in it.
+*/
+int post_run_py_batch( struct network * net, const struct run_files * jobs, int num_jobs,
+                       const struct run_options * options, int * status )
+{
+	struct run run;
+	int    failed;
+	int    ret;
+	int    i;
+
+	failed = 0;
+
+	for (i = 0; i < num_jobs; i++) {
+		printf( "post_run_py: batch job %d of %d\n", i + 1, num_jobs );
+
+		ret = post_run_py_network( &run, net, &jobs[i], options );
+		release_run( &run );
+
+		if (status != NULL)
+			status[i] = ret;
+
+		if (ret != 0)
+			failed++;
+	}
+
+	return failed;
 }
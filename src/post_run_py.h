@@ -0,0 +1,460 @@
+#ifndef POST_RUN_PY_H
+#define POST_RUN_PY_H
+
+#include <stddef.h>
+
+/* post_run_py.h
+
+   Records and routines shared between the files of post_run_py. See
+   post_run_py.c for what the program does as a whole.
+*/
+
+#define  TRUE                     (1)
+#define  FALSE                    (0)
+
+#define  MAX_LINE_LEN             (4096)
+
+/* Longest node and edge string attributes that are kept, as in the old fixed
+   size fields. Node names are always kept whole, as paths refer to them. */
+#define  MAX_NODE_STR_LEN         (15)
+#define  MAX_EDGE_STR_LEN         (47)
+
+/* The network file is mapped read-only and string attributes refer back into
+   the mapping, so nothing is copied until a record is written out. A
+   compressed file is decompressed into 'allocated' memory instead. */
+struct mapped_file {
+	char * data;
+	size_t size;
+	int    allocated;
+};
+
+struct str_view {
+	size_t off;
+	size_t len;
+};
+
+/* Bump allocator owning everything allocated for one run, see arena.c. */
+struct arena {
+	struct arena_chunk * last;
+	size_t allocated;
+	int    chunks;
+};
+
+/* Interning pool for the attributes that only have a handful of distinct
+   values (Layer, interaction, sh_interaction and Time). Each distinct value
+   is kept once, as a view into the network file, and records hold its symbol,
+   an index into 'strings'. Symbol 0 is the empty string. */
+struct string_pool {
+	int    num;
+	int    cap;
+	struct str_view * strings;
+	int    size;
+	int  * slots;
+};
+
+/* Open-addressed hash table mapping node names to node indexes, built once
+   after the network is loaded so that name lookups don't have to walk the
+   whole name column. The table size is always a power of two, and empty
+   slots hold -1. */
+struct node_index {
+	int size;
+	const char * text;
+	const struct str_view * names;
+	int * slots;
+};
+
+/* A set of names, kept in a buffer of its own with a hash table over them
+   like the node index, see network.c. */
+struct name_set {
+	int    num;
+	char * text;
+	size_t text_len;
+	size_t text_cap;
+	struct str_view * names;
+	int    size;
+	int  * slots;
+};
+
+/* Compressed sparse row adjacency of the edge list. Rows are the distinct
+   source node ids in ascending order, and each row holds its edges sorted
+   by target id, so a (source, target) lookup is two binary searches. */
+struct edge_adjacency {
+	int num_rows;
+	int * row_source;
+	int * row_start;
+	int * col_target;
+	int * col_edge;
+};
+
+/* A loaded network. Node and edge attributes are stored column by column in
+   file order, with the flags packed into bitsets (see bit_test()), so the
+   loops over names, ids and flags only touch the columns they need. String
+   attributes are views into 'text', which is the mapped .cyjs file, or
+   symbols of 'pool'. Once open_network() has built the lookup tables (which
+   live in 'arena') the network isn't changed again, so it can be used for any
+   number of runs. A network opened from a snapshot has its columns, tables
+   and text all in the 'snapshot' mapping instead, see snapshot.c. How long
+   opening it took, and how many bytes were read, is kept for the metrics of
+   the runs against it. */
+struct network {
+	struct mapped_file file;
+	struct mapped_file snapshot;
+	const char * text;
+	struct string_pool pool;
+	struct arena arena;
+	struct node_index index;
+	struct edge_adjacency adj;
+	int    num_nodes;
+	int    num_edges;
+	double load_seconds;
+	long   load_bytes;
+	int    node_cap;
+	int    edge_cap;
+
+	int * node_id;
+	struct str_view * node_shared_name;
+	struct str_view * node_name;
+	int * node_Layer;
+	double * node_FoldChange;
+	int * node_SUID;
+	int * node_Prize;
+	double * node_x;
+	double * node_y;
+	unsigned int * node_isExcludedFromPaths;
+	unsigned int * node_isInPath;
+	unsigned int * node_selected;
+
+	int * edge_id;
+	int * edge_source;
+	int * edge_target;
+	struct str_view * edge_shared_name;
+	int * edge_sh_interaction;
+	struct str_view * edge_name;
+	int * edge_interaction;
+	int * edge_Time;
+	int * edge_SUID;
+	unsigned int * edge_isInPath;
+	unsigned int * edge_selected;
+};
+
+#define  BIT_WORDS(n)             (((n) + 31) / 32)
+
+static inline int bit_test( const unsigned int * bits, int i ) {
+	return (bits[i >> 5] >> (i & 31)) & 1;
+}
+
+static inline void bit_set( unsigned int * bits, int i ) {
+	bits[i >> 5] |= 1u << (i & 31);
+}
+
+static inline void bit_assign( unsigned int * bits, int i, int val ) {
+	if (val)
+		bits[i >> 5] |= 1u << (i & 31);
+	else
+		bits[i >> 5] &= ~(1u << (i & 31));
+}
+
+/* The number of bits set of the first 'n'; the rest are always clear. */
+static inline int bit_count( const unsigned int * bits, int n ) {
+	int    count;
+	int    i;
+
+	for (count = 0, i = 0; i < BIT_WORDS( n ); i++)
+		count += __builtin_popcount( bits[i] );
+
+	return count;
+}
+
+/* The highest set bit at or below 'i', or -1, skipping empty words whole. */
+static inline int bit_prev( const unsigned int * bits, int i ) {
+	unsigned int word;
+
+	if (i < 0)
+		return -1;
+
+	word = bits[i >> 5] & (0xffffffffu >> (31 - (i & 31)));
+
+	for (i >>= 5; word == 0; word = bits[i])
+		if (--i < 0)
+			return -1;
+
+	return (i << 5) + 31 - __builtin_clz( word );
+}
+
+/* The detected paths of a run in file order, see path_list.c. The hops of
+   path p are hop_node[path_start[p]] up to hop_node[path_start[p + 1]], and
+   'rank' and 'cost' are the first two fields of its line of the paths file.
+   A hop's node is resolved as the path is read, and is -1 - an index into
+   'missing' for a name that isn't in the network, kept once for all the
+   hops with that name. A hop and the next one make a pair, kept once for
+   all the paths with the same two nodes in a row; 'pairs_before' and
+   'missing_before' are how many pairs and missing names there were when
+   each path began.
+   The edge of a pair is resolved by flag_nodes_and_edges(), and stays -1 if
+   there is none. */
+struct path_list {
+	int    num_paths;
+	int    path_cap;
+	long   num_hops;
+	long   hop_cap;
+	long * path_start;
+	int  * rank;
+	double * cost;
+	int  * pairs_before;
+	int  * missing_before;
+	int  * hop_node;
+	int  * hop_pair;
+	int    num_pairs;
+	int    pair_cap;
+	int  * pair_from;
+	int  * pair_to;
+	int  * pair_edge;
+	int    table_size;
+	int  * pair_table;
+	int    num_missing;
+	int    missing_cap;
+	char ** missing;
+	int    missing_table_size;
+	int  * missing_table;
+};
+
+/* The edge from a hop to the next one, or -1. */
+static inline int hop_edge( const struct path_list * paths, long hop ) {
+	int pair = paths->hop_pair[hop];
+
+	return (pair >= 0) ? paths->pair_edge[pair] : -1;
+}
+
+/* The files one run reads and writes. */
+struct run_files {
+	const char * paths;
+	const char * in_txt;
+	const char * out_cyjs;
+	const char * out_txt;
+};
+
+/* How a run is carried out. With 'ksp_paths' set the paths aren't read from
+   the paths file but found by find_shortest_paths(), that many of them. With
+   'follow' set the paths file is read while it is still being written, see
+   follow_out_paths(): it is waited for up to 'follow_wait' seconds (or for
+   ever if that is negative) to be made, and taken as complete once it
+   hasn't grown for 'follow_idle' seconds. Following stops early if
+   'interrupted' is set and returns TRUE. With 'metrics_file' set every run
+   appends its metrics to it as a JSON line. */
+struct run_options {
+	int    write_files;
+	int    num_threads;
+	int    compact_json;
+	int    ksp_paths;
+	int    follow;
+	double follow_wait;
+	double follow_idle;
+	int  (*interrupted)( void );
+	const char * metrics_file;
+};
+
+/* What a run did and how long each phase of it took, by the monotonic clock.
+   The load phase is that of the network the run is against; everything
+   else is for the latest call that made or extended the run. */
+#define  PHASE_LOAD               (0)
+#define  PHASE_IN_TXT             (1)
+#define  PHASE_PATHS              (2)
+#define  PHASE_FLAG               (3)
+#define  PHASE_WRITE              (4)
+#define  PHASE_REPORT             (5)
+#define  NUM_PHASES               (6)
+
+extern const char * const phase_names[NUM_PHASES];
+
+struct run_metrics {
+	double seconds[NUM_PHASES];
+	long   bytes_parsed;
+	int    nodes_loaded;
+	int    edges_loaded;
+	int    names_resolved;
+	int    names_missing;
+	int    paths_loaded;
+	long   hops_loaded;
+	int    hop_pairs;
+	int    nodes_flagged;
+	int    edges_flagged;
+	long   bytes_written;
+	long   report_syscalls;
+};
+
+/* Lines of the text report of a run, collected in memory and written out in
+   one go by flush_out_messages(). 'last' is the latest line, for callers that
+   don't write the report. The counters record what the flush cost. A flush
+   keeps the first 'keep' bytes of the old report file in front of the new
+   lines, all of it when 'keep' is negative, and notes in 'start' where the
+   new lines went, or -1 if the report couldn't be replaced. */
+struct report {
+	char * buf;
+	size_t len;
+	size_t cap;
+	char   last[MAX_LINE_LEN+1];
+	long   bytes_written;
+	int    syscalls;
+	long   keep;
+	long   start;
+};
+
+/* Everything belonging to one run against a loaded network: its report, the
+   detected paths and which nodes and edges they flag for output. It all
+   belongs to the run, in its own arena or path list, so the network itself
+   is never changed and any number of runs can use it at the same time. How
+   far the paths file has been read is kept so that the run can be extended
+   with paths appended to it later, see post_run_py_extend(), as is the
+   search for paths that find_shortest_paths() carries on with, and how many
+   of the paths have been flagged so far. So is what the report says before
+   the paths, and where in the report file the run's lines start (-1 before
+   they are written), for the report to be written anew when it's extended. */
+struct run {
+	struct network * net;
+	const struct run_files * files;
+	struct arena arena;
+	struct report report;
+	struct run_metrics metrics;
+	int    num_source;
+	int    num_target;
+	struct path_list paths;
+	int    paths_flagged;
+	int    paths_lines;
+	long   paths_end;
+	long   last_line_off;
+	unsigned int last_line_hash;
+	struct path_search * search;
+	unsigned int * node_source;
+	unsigned int * node_target;
+	unsigned int * node_output;
+	unsigned int * edge_output;
+	char * report_head;
+	size_t report_head_len;
+	long   report_start;
+};
+
+/* json_scan.c: SAX style JSON tokenizer. The event callback gets the type of
+   each token and, for keys, strings, numbers and literals, its text (strings
+   without the quotes, escapes left as they are). A non-zero return from the
+   callback stops the scan and is passed back to the caller. */
+#define  JSON_OBJECT_START        (1)
+#define  JSON_OBJECT_END          (2)
+#define  JSON_ARRAY_START         (3)
+#define  JSON_ARRAY_END           (4)
+#define  JSON_KEY                 (5)
+#define  JSON_STRING              (6)
+#define  JSON_NUMBER              (7)
+#define  JSON_TRUE                (8)
+#define  JSON_FALSE               (9)
+#define  JSON_NULL                (10)
+
+#define  JSON_MAX_DEPTH           (256)
+#define  JSON_SYNTAX_ERROR        (-1)
+#define  JSON_SKIP                (-2)
+
+typedef int (*json_event_fn)( void * user, int type, const char * text, size_t len );
+
+int json_scan( const char * data, size_t size, json_event_fn event, void * user, size_t * stop_off );
+int json_scan_list( const char * data, size_t size, json_event_fn event, void * user, size_t * stop_off );
+size_t json_skip( const char * data, size_t size, size_t off );
+
+/* arena.c */
+void arena_init( struct arena * arena );
+void * arena_alloc( struct arena * arena, size_t size );
+void * arena_calloc( struct arena * arena, size_t count, size_t size );
+void arena_release( struct arena * arena );
+
+/* network.c */
+unsigned int hash_name( const char * name, size_t len );
+int intern_string( struct network * net, size_t off, size_t len );
+void init_network( struct network * net );
+int add_node( struct network * net );
+int add_edge( struct network * net );
+int append_network( struct network * net, struct network * part );
+int open_network( const char * file_name, struct network * net, int num_threads, struct report * report );
+int open_network_subset( const char * file_name, struct network * net, const struct name_set * wanted,
+                         int num_threads, struct report * report );
+int lookup_node( struct node_index * index, const char * name );
+int find_edge( struct edge_adjacency * adj, int from_id, int to_id );
+void free_network( struct network * net );
+void init_name_set( struct name_set * set );
+void free_name_set( struct name_set * set );
+int add_name( struct name_set * set, const char * name, size_t len );
+int has_name( const struct name_set * set, const char * name, size_t len );
+
+/* cyjs_load.c */
+int map_file( const char * file_name, struct mapped_file * file );
+void unmap_file( struct mapped_file * file );
+int load_network( const char * file_name, struct network * net, const struct name_set * wanted, int num_threads,
+                  struct report * report );
+
+/* cyjs_write.c */
+int write_subset_network( struct run * run, int compact );
+
+/* compress.c: gzip (and with HAVE_ZSTD, zstd) files. An encoder writes
+   through to a file descriptor, compressing on the way. */
+#define  COMPRESS_NONE            (0)
+#define  COMPRESS_GZIP            (1)
+#define  COMPRESS_ZSTD            (2)
+
+struct encoder {
+	int    type;
+	int    fd;
+	int    failed;
+	long   bytes_written;
+	void * state;
+	char * chunk;
+};
+
+int decompress_file( struct mapped_file * file );
+int output_compression( const char * file_name );
+int encoder_open( struct encoder * enc, int type, int fd );
+void encoder_write( struct encoder * enc, const char * data, size_t len );
+int encoder_close( struct encoder * enc );
+
+/* snapshot.c */
+int load_snapshot( const char * file_name, struct network * net );
+int save_snapshot( const char * file_name, struct network * net );
+
+/* path_list.c */
+void init_path_list( struct path_list * paths );
+void free_path_list( struct path_list * paths );
+int begin_path( struct path_list * paths, int rank, double cost );
+int add_hop( struct path_list * paths, int node );
+int missing_node( struct path_list * paths, const char * name, size_t len );
+void truncate_paths( struct path_list * paths, int first );
+const char * hop_name( const struct network * net, const struct path_list * paths, int node, size_t * len );
+
+/* flag_paths.c */
+int flag_nodes_and_edges( struct run * run, int first_path, int num_threads );
+
+/* ksp.c */
+int find_shortest_paths( struct run * run, int k );
+
+/* post_run_py.c */
+double monotonic_seconds( void );
+int write_out_message( struct report * report, char * message );
+const char * last_out_message( const struct report * report );
+int create_temp_file( const char * file_name, char * tmp_name, size_t size );
+int open_output( const char * file_name, char * tmp_name, size_t size );
+int finish_output( int fd, const char * file_name, const char * tmp_name, int ok );
+int flush_out_messages( struct report * report, const char * report_file_name );
+void begin_report( struct report * report );
+int end_report( struct report * report, int ret, const char * report_file_name );
+void init_run( struct run * run );
+int prepare_run( struct run * run, struct network * net, const struct run_files * files );
+int process_in_nodes( struct run * run, const char * in_file_name );
+int load_out_paths( struct run * run, const char * paths_file_name );
+int follow_out_paths( struct run * run, const char * paths_file_name, const struct run_options * options );
+void write_paths( struct run * run, int first_path );
+void release_run( struct run * run );
+void default_run_files( struct run_files * files, const char * paths_file_name );
+void default_run_options( struct run_options * options );
+int post_run_py( int argc, char ** argv );
+int post_run_py_network( struct run * run, struct network * net, const struct run_files * files,
+                         const struct run_options * options );
+int post_run_py_extend( struct run * run, const struct run_options * options );
+int post_run_py_batch( struct network * net, const struct run_files * jobs, int num_jobs,
+                       const struct run_options * options, int * status );
+
+#endif
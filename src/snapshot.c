@@ -0,0 +1,482 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "post_run_py.h"
+
+/* snapshot.c
+
+   A binary snapshot of a loaded network, kept next to the .cyjs file it was
+   made from as '<file>.snap'. It holds every column, the interned strings,
+   the name index and the edge adjacency as fixed-width arrays, followed by a
+   table with the text of the string attributes. Opening a network from its
+   snapshot is just mapping the file and pointing the columns into it, with
+   no parsing and no tables to build.
+
+   The header records the size, modification time and content hash of the
+   .cyjs file. The snapshot is used if size and time still match; if only the
+   time differs the file is hashed, so a copy or a touch of an unchanged
+   network doesn't throw the snapshot away, and the new time is written into
+   the header so that it is only hashed the once. Anything else means the
+   network is loaded from the .cyjs file and the snapshot is written again.
+
+   A snapshot that matches its network can still have been cut short or
+   damaged since it was written, so every offset in it that a lookup would
+   follow (string views, symbols, index slots and the adjacency rows) is
+   checked against the counts of the header before it is used.
+*/
+
+#define  SNAPSHOT_MAGIC           "CYTOSNAP"
+#define  SNAPSHOT_VERSION         (3)
+#define  SNAPSHOT_BYTE_ORDER      (0x01020304u)
+#define  SNAPSHOT_ALIGN           (16)
+#define  MAX_SNAPSHOT_COLUMNS     (40)
+
+#define  ALIGN_UP(n)              (((n) + SNAPSHOT_ALIGN - 1) & ~((size_t) SNAPSHOT_ALIGN - 1))
+
+struct snapshot_header {
+	char   magic[8];
+	unsigned int version;
+	unsigned int byte_order;
+	unsigned int header_size;
+	unsigned int view_size;
+	long long source_size;
+	long long source_mtime;
+	long long source_mtime_nsec;
+	unsigned long long source_hash;
+	int    num_nodes;
+	int    num_edges;
+	int    num_strings;
+	int    index_size;
+	int    num_rows;
+	int    max_node_str_len;
+	int    max_edge_str_len;
+	int    unused;
+	long long text_size;
+};
+
+struct snapshot_column {
+	void ** data;
+	size_t size;
+};
+
+/* The arrays of a network in the order they are stored, with their sizes
+   taken from the counts already in 'net'. Returns the number of arrays.
+*/
+static int snapshot_columns( struct network * net, struct snapshot_column * col ) {
+	size_t node_words = BIT_WORDS( net->num_nodes ) * sizeof( unsigned int );
+	size_t edge_words = BIT_WORDS( net->num_edges ) * sizeof( unsigned int );
+	int    n = 0;
+
+#define  COLUMN(p, bytes)         (col[n].data = (void **) &(p), col[n].size = (bytes), n++)
+
+	COLUMN( net->node_id, net->num_nodes * sizeof( int ) );
+	COLUMN( net->node_shared_name, net->num_nodes * sizeof( struct str_view ) );
+	COLUMN( net->node_name, net->num_nodes * sizeof( struct str_view ) );
+	COLUMN( net->node_Layer, net->num_nodes * sizeof( int ) );
+	COLUMN( net->node_FoldChange, net->num_nodes * sizeof( double ) );
+	COLUMN( net->node_SUID, net->num_nodes * sizeof( int ) );
+	COLUMN( net->node_Prize, net->num_nodes * sizeof( int ) );
+	COLUMN( net->node_x, net->num_nodes * sizeof( double ) );
+	COLUMN( net->node_y, net->num_nodes * sizeof( double ) );
+	COLUMN( net->node_isExcludedFromPaths, node_words );
+	COLUMN( net->node_isInPath, node_words );
+	COLUMN( net->node_selected, node_words );
+
+	COLUMN( net->edge_id, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_source, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_target, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_shared_name, net->num_edges * sizeof( struct str_view ) );
+	COLUMN( net->edge_sh_interaction, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_name, net->num_edges * sizeof( struct str_view ) );
+	COLUMN( net->edge_interaction, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_Time, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_SUID, net->num_edges * sizeof( int ) );
+	COLUMN( net->edge_isInPath, edge_words );
+	COLUMN( net->edge_selected, edge_words );
+
+	COLUMN( net->pool.strings, net->pool.num * sizeof( struct str_view ) );
+	COLUMN( net->index.slots, net->index.size * sizeof( int ) );
+	COLUMN( net->adj.row_source, net->adj.num_rows * sizeof( int ) );
+	COLUMN( net->adj.row_start, (net->adj.num_rows + 1) * sizeof( int ) );
+	COLUMN( net->adj.col_target, net->num_edges * sizeof( int ) );
+	COLUMN( net->adj.col_edge, net->num_edges * sizeof( int ) );
+
+#undef COLUMN
+
+	return n;
+}
+
+static void snapshot_name( const char * file_name, char * snap_name, size_t size ) {
+	snprintf( snap_name, size, "%s.snap", file_name );
+}
+
+static long long mtime_nsec( struct stat * st ) {
+#if defined(__APPLE__)
+	return st->st_mtimespec.tv_nsec;
+#else
+	return st->st_mtim.tv_nsec;
+#endif
+}
+
+/* 64 bit FNV-1a of the whole network file.
+*/
+static unsigned long long hash_file( const char * file_name, int * ok ) {
+	struct mapped_file file;
+	unsigned long long h = 14695981039346656037ull;
+	size_t i;
+
+	*ok = (map_file( file_name, &file ) == 0);
+
+	if (!*ok)
+		return 0;
+
+	for (i = 0; i < file.size; i++) {
+		h ^= (unsigned char) file.data[i];
+		h *= 1099511628211ull;
+	}
+
+	unmap_file( &file );
+	return h;
+}
+
+static int views_in_bounds( const struct str_view * views, int num, size_t text_size ) {
+	int    i;
+
+	for (i = 0; i < num; i++) {
+		if (views[i].off > text_size || views[i].len > text_size - views[i].off)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static int symbols_in_bounds( const int * syms, int num, int num_strings ) {
+	int    i;
+
+	for (i = 0; i < num; i++) {
+		if (syms[i] < 0 || syms[i] >= num_strings)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Whether everything a lookup in the network follows stays within the
+   snapshot, the text of which is 'text_size' bytes.
+*/
+static int snapshot_in_bounds( const struct network * net, size_t text_size ) {
+	const struct edge_adjacency * adj = &net->adj;
+	int    i;
+
+	if (!views_in_bounds( net->node_name, net->num_nodes, text_size ) ||
+	    !views_in_bounds( net->node_shared_name, net->num_nodes, text_size ) ||
+	    !views_in_bounds( net->edge_name, net->num_edges, text_size ) ||
+	    !views_in_bounds( net->edge_shared_name, net->num_edges, text_size ) ||
+	    !views_in_bounds( net->pool.strings, net->pool.num, text_size ))
+		return FALSE;
+
+	if (!symbols_in_bounds( net->node_Layer, net->num_nodes, net->pool.num ) ||
+	    !symbols_in_bounds( net->edge_sh_interaction, net->num_edges, net->pool.num ) ||
+	    !symbols_in_bounds( net->edge_interaction, net->num_edges, net->pool.num ) ||
+	    !symbols_in_bounds( net->edge_Time, net->num_edges, net->pool.num ))
+		return FALSE;
+
+	for (i = 0; i < net->index.size; i++) {
+		if (net->index.slots[i] < -1 || net->index.slots[i] >= net->num_nodes)
+			return FALSE;
+	}
+
+	/* the rows are in order and cover the edges exactly */
+	if (adj->row_start[0] != 0 || adj->row_start[adj->num_rows] != net->num_edges)
+		return FALSE;
+
+	for (i = 0; i < adj->num_rows; i++) {
+		if (adj->row_start[i] > adj->row_start[i + 1])
+			return FALSE;
+	}
+
+	for (i = 0; i < net->num_edges; i++) {
+		if (adj->col_edge[i] < 0 || adj->col_edge[i] >= net->num_edges)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Put the modification time of the network file in the header of its
+   snapshot, once the file has been found unchanged by its hash. Just the
+   time is written, in place; a load that sees half of it only hashes the
+   file again. Failing to isn't an error.
+*/
+static void update_snapshot_time( const char * snap_name, struct stat * st ) {
+	long long mtime[2];
+	int    fd;
+
+	mtime[0] = (long long) st->st_mtime;
+	mtime[1] = mtime_nsec( st );
+
+	if ((fd = open( snap_name, O_WRONLY )) < 0)
+		return;
+
+	if (pwrite( fd, mtime, sizeof( mtime ), offsetof( struct snapshot_header, source_mtime ) ) !=
+	    (ssize_t) sizeof( mtime ))
+		printf( "could not update the time in '%s'\n", snap_name );
+
+	close( fd );
+}
+
+/* Open the network from the snapshot of 'file_name' if there is an up to date
+   one. Returns 0 if it was, otherwise -1 with 'net' left empty.
+*/
+int load_snapshot( const char * file_name, struct network * net ) {
+	struct snapshot_header hdr;
+	struct snapshot_column col[MAX_SNAPSHOT_COLUMNS];
+	char   snap_name[MAX_LINE_LEN];
+	struct stat st;
+	size_t off;
+	int    num_columns;
+	int    hashed;
+	int    ok;
+	int    i;
+
+	init_network( net );
+
+	if (stat( file_name, &st ) != 0)
+		return -1;
+
+	snapshot_name( file_name, snap_name, sizeof( snap_name ) );
+
+	if (map_file( snap_name, &net->snapshot ) != 0)
+		return -1;
+
+	if (net->snapshot.size < sizeof( hdr ))
+		goto stale;
+
+	memcpy( &hdr, net->snapshot.data, sizeof( hdr ) );
+
+	if (memcmp( hdr.magic, SNAPSHOT_MAGIC, sizeof( hdr.magic ) ) != 0 ||
+	    hdr.version != SNAPSHOT_VERSION ||
+	    hdr.byte_order != SNAPSHOT_BYTE_ORDER ||
+	    hdr.header_size != sizeof( hdr ) ||
+	    hdr.view_size != sizeof( struct str_view ) ||
+	    hdr.max_node_str_len != MAX_NODE_STR_LEN ||
+	    hdr.max_edge_str_len != MAX_EDGE_STR_LEN)
+		goto stale;
+
+	if (hdr.source_size != (long long) st.st_size)
+		goto stale;
+
+	hashed = (hdr.source_mtime != (long long) st.st_mtime || hdr.source_mtime_nsec != mtime_nsec( &st ));
+
+	if (hashed && (hash_file( file_name, &ok ) != hdr.source_hash || !ok))
+		goto stale;
+
+	/* the counts size the columns, and the index always has empty slots to
+	   end a probe */
+	if (hdr.num_nodes < 0 || hdr.num_edges < 0 || hdr.num_strings < 0 || hdr.text_size < 0 ||
+	    hdr.num_rows < 0 || hdr.num_rows > hdr.num_edges ||
+	    hdr.index_size < 2 * (long long) hdr.num_nodes || hdr.index_size < 1 ||
+	    (hdr.index_size & (hdr.index_size - 1)) != 0)
+		goto stale;
+
+	net->num_nodes = hdr.num_nodes;
+	net->num_edges = hdr.num_edges;
+	net->node_cap = hdr.num_nodes;
+	net->edge_cap = hdr.num_edges;
+	net->pool.num = hdr.num_strings;
+	net->pool.cap = hdr.num_strings;
+	net->index.size = hdr.index_size;
+	net->adj.num_rows = hdr.num_rows;
+
+	/* point the arrays into the mapping, checking it is as long as the header says */
+	num_columns = snapshot_columns( net, col );
+	off = ALIGN_UP( sizeof( hdr ) );
+
+	for (i = 0; i < num_columns; i++) {
+		if (off + col[i].size > net->snapshot.size)
+			goto stale;
+
+		*col[i].data = net->snapshot.data + off;
+		off = ALIGN_UP( off + col[i].size );
+	}
+
+	if (off + (size_t) hdr.text_size != net->snapshot.size)
+		goto stale;
+
+	if (!snapshot_in_bounds( net, (size_t) hdr.text_size ))
+		goto stale;
+
+	net->text = net->snapshot.data + off;
+	net->index.text = net->text;
+	net->index.names = net->node_name;
+
+	if (hashed)
+		update_snapshot_time( snap_name, &st );
+
+	return 0;
+
+stale:
+	unmap_file( &net->snapshot );
+	init_network( net );
+	return -1;
+}
+
+/* Copy the text of 'num' views into 'table', pointing the copies in 'out' at
+   it. Where the text is the same as that of the view in 'same' (views already
+   into the table, if given) that copy is shared instead.
+*/
+static void copy_views( const char * text, const struct str_view * in, const struct str_view * same,
+                        struct str_view * out, int num, char * table, size_t * used )
+{
+	int    i;
+
+	for (i = 0; i < num; i++) {
+		if (same != NULL && in[i].len == same[i].len &&
+		    memcmp( text + in[i].off, table + same[i].off, in[i].len ) == 0)
+		{
+			out[i] = same[i];
+			continue;
+		}
+
+		memcpy( table + *used, text + in[i].off, in[i].len );
+		out[i].off = *used;
+		out[i].len = in[i].len;
+		*used += in[i].len;
+	}
+}
+
+/* Write the snapshot of a freshly loaded network. The snapshot is written to
+   a temporary file of its own and renamed into place, so another process
+   or thread never sees half of one. Failing to write it isn't an error for the run.
+*/
+int save_snapshot( const char * file_name, struct network * net ) {
+	static const char zeros[SNAPSHOT_ALIGN];
+	struct snapshot_header hdr;
+	struct snapshot_column col[MAX_SNAPSHOT_COLUMNS];
+	struct network snap;
+	char   snap_name[MAX_LINE_LEN];
+	char   tmp_name[MAX_LINE_LEN + 64];
+	struct stat st;
+	FILE * out;
+	char * table;
+	size_t table_size;
+	size_t used;
+	size_t off;
+	int    num_columns;
+	int    fd;
+	int    ok;
+	int    ret;
+	int    i;
+
+	if (stat( file_name, &st ) != 0)
+		return -1;
+
+	/* gather the text of every string attribute into one table */
+	table_size = 0;
+
+	for (i = 0; i < net->num_nodes; i++)
+		table_size += net->node_name[i].len + net->node_shared_name[i].len;
+
+	for (i = 0; i < net->num_edges; i++)
+		table_size += net->edge_name[i].len + net->edge_shared_name[i].len;
+
+	for (i = 0; i < net->pool.num; i++)
+		table_size += net->pool.strings[i].len;
+
+	snap = *net;
+	snap.node_name = malloc( net->num_nodes * sizeof( struct str_view ) + 1 );
+	snap.node_shared_name = malloc( net->num_nodes * sizeof( struct str_view ) + 1 );
+	snap.edge_name = malloc( net->num_edges * sizeof( struct str_view ) + 1 );
+	snap.edge_shared_name = malloc( net->num_edges * sizeof( struct str_view ) + 1 );
+	snap.pool.strings = malloc( net->pool.num * sizeof( struct str_view ) + 1 );
+	table = malloc( table_size + 1 );
+	ret = -1;
+
+	if (snap.node_name == NULL || snap.node_shared_name == NULL || snap.edge_name == NULL ||
+	    snap.edge_shared_name == NULL || snap.pool.strings == NULL || table == NULL)
+		goto done;
+
+	used = 0;
+	copy_views( net->text, net->node_name, NULL, snap.node_name, net->num_nodes, table, &used );
+	copy_views( net->text, net->edge_name, NULL, snap.edge_name, net->num_edges, table, &used );
+	copy_views( net->text, net->pool.strings, NULL, snap.pool.strings, net->pool.num, table, &used );
+
+	/* shared names are nearly always the same as the names */
+	copy_views( net->text, net->node_shared_name, snap.node_name, snap.node_shared_name, net->num_nodes, table, &used );
+	copy_views( net->text, net->edge_shared_name, snap.edge_name, snap.edge_shared_name, net->num_edges, table, &used );
+
+	memset( &hdr, 0, sizeof( hdr ) );
+	memcpy( hdr.magic, SNAPSHOT_MAGIC, sizeof( hdr.magic ) );
+	hdr.version = SNAPSHOT_VERSION;
+	hdr.byte_order = SNAPSHOT_BYTE_ORDER;
+	hdr.header_size = sizeof( hdr );
+	hdr.view_size = sizeof( struct str_view );
+	hdr.source_size = st.st_size;
+	hdr.source_mtime = st.st_mtime;
+	hdr.source_mtime_nsec = mtime_nsec( &st );
+	hdr.source_hash = hash_file( file_name, &ok );
+	hdr.num_nodes = net->num_nodes;
+	hdr.num_edges = net->num_edges;
+	hdr.num_strings = net->pool.num;
+	hdr.index_size = net->index.size;
+	hdr.num_rows = net->adj.num_rows;
+	hdr.max_node_str_len = MAX_NODE_STR_LEN;
+	hdr.max_edge_str_len = MAX_EDGE_STR_LEN;
+	hdr.text_size = used;
+
+	if (!ok)
+		goto done;
+
+	snapshot_name( file_name, snap_name, sizeof( snap_name ) );
+	fd = create_temp_file( snap_name, tmp_name, sizeof( tmp_name ) );
+
+	if (fd < 0)
+		goto done;
+
+	out = fdopen( fd, "wb" );
+
+	if (out == NULL) {
+		close( fd );
+		remove( tmp_name );
+		goto done;
+	}
+
+	fwrite( &hdr, sizeof( hdr ), 1, out );
+	off = sizeof( hdr );
+	num_columns = snapshot_columns( &snap, col );
+
+	for (i = 0; i < num_columns; i++) {
+		fwrite( zeros, 1, ALIGN_UP( off ) - off, out );
+		off = ALIGN_UP( off );
+
+		fwrite( *col[i].data, 1, col[i].size, out );
+		off += col[i].size;
+	}
+
+	fwrite( zeros, 1, ALIGN_UP( off ) - off, out );
+	fwrite( table, 1, used, out );
+
+	ok = !ferror( out );
+
+	if (fclose( out ) != 0 || !ok || rename( tmp_name, snap_name ) != 0) {
+		remove( tmp_name );
+		goto done;
+	}
+
+	ret = 0;
+
+done:
+	free( snap.node_name );
+	free( snap.node_shared_name );
+	free( snap.edge_name );
+	free( snap.edge_shared_name );
+	free( snap.pool.strings );
+	free( table );
+
+	return ret;
+}